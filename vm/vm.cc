@@ -9,79 +9,782 @@
 #include <sstream>
 #include <algorithm>
 #include <unordered_map>
-#include <unordered_set>
+#include <string_view>
+#include <cstdint>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <new>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <cerrno>
 
 using namespace std;
 
-// Structure representing a page table entry
+// Page table entry states, printed through PAGE_STATUS_NAMES
+enum PageStatus : char {
+    PAGE_UNUSED,
+    PAGE_MAPPED,
+    PAGE_STOLEN
+};
+
+static const char *const PAGE_STATUS_NAMES[] = {"UNUSED", "MAPPED", "STOLEN"};
+
+// Latest operation on a page, as stored in Page::lastOperation
+enum PageOperation : char {
+    OPERATION_NONE,   // Never mapped
+    OPERATION_READ,
+    OPERATION_WRITE
+};
+
+// Frame numbers are packed into 26 bits of the page table entry
+const size_t MAX_FRAMES = (1 << 25) - 1;
+
+// Longest --frames, --page-size or --pages list, each entry being a whole simulation
+const size_t MAX_SWEEP_VALUES = 4096;
+
+// Structure representing a page table entry, packed into one 32-bit word so 100M pages fit in
+// 400 MB. Backing store blocks live in a side table that only -w allocates.
 struct Page {
-    int frameNumber = -1;
-    int isOnDisk = 0;
-    int backingStoreBlock = -1;
-    string status = "UNUSED";
+    int frameNumber : 26;          // -1 when not resident
+    unsigned status : 2;           // PageStatus
+    unsigned isOnDisk : 1;
+    unsigned isRetired : 1;        // -f: the trace never references this page again
+    unsigned lastOperation : 2;    // PageOperation of the latest reference
+
+    Page() : frameNumber(-1), status(PAGE_UNUSED), isOnDisk(0), isRetired(0), lastOperation(OPERATION_NONE) {}
 };
+static_assert(sizeof(Page) == 4, "page table entries must stay one word");
 
-// Structure representing a frame table entry
-struct Frame {
+// Structure representing a frame table entry, one 32-byte slot so a frame never spans cache lines
+struct alignas(32) Frame {
+    long long pageNumber = -1;
     int first_use = -1;
-    int isInUse = 0;
-    int isDirty = 0;
     int last_use = -1;
-    int pageNumber = -1;
+    int lessRecentFrame = -1;       // LRU recency (FIFO load order) list link toward the victim end
+    int moreRecentFrame = -1;       // LRU recency (FIFO load order) list link toward the newest end
+    unsigned isInUse : 1;
+    unsigned isDirty : 1;
+    unsigned isReferenced : 1;      // CLOCK/ESC reference bit, set on every reference
+    unsigned handPassedOver : 1;    // ESC/WSCLOCK: the hand already spared this frame (dirty or young) since its last reference
+    unsigned isPrefetched : 1;      // Loaded by the prefetcher and not referenced since
+    unsigned isCleaned : 1;         // The page-out daemon wrote the page back and it has not been written since
+    unsigned isHugeFill : 1;        // Loaded to complete a huge page promotion and not referenced since
+    unsigned remoteNode : 7;        // --numa-migrate: 1 + the remote node that made the last reference, 0 if local
+
+    Frame() : isInUse(0), isDirty(0), isReferenced(0), handPassedOver(0), isPrefetched(0), isCleaned(0), isHugeFill(0), remoteNode(0) {}
 };
+static_assert(sizeof(Frame) == 32, "frame table entries must stay one 32-byte slot");
 
 // Structure representing a backing store block
 struct BackingStoreBlock {
     int writeCount = 0;
     int isInUse = 0;
-    int pageNumber = -1;
+    long long pageNumber = -1;
     int readCount = 0;
 };
 
+// Kinds of records found in a trace, text or binary
+enum RecordKind : char {
+    RECORD_SKIP,              // Comment or empty line
+    RECORD_PRINT,
+    RECORD_DEBUG,
+    RECORD_NODEBUG,
+    RECORD_REFERENCE,
+    RECORD_BAD_FORMAT,        // Counted as a reference but not simulated
+    RECORD_BAD_OPERATION,
+    RECORD_BAD_LOCATION,
+    RECORD_LOCATION_RANGE,
+    RECORD_BAD_CPU            // --numa: the id after the address is not a number
+};
+
+// Where a replay stands in the trace: enough to pick up parsing at the next record
+struct TracePosition {
+    size_t offset;
+    long long previousAddress;  // Binary traces store addresses as deltas from this
+    size_t recordIndex;
+};
+
+// Header of a checkpoint snapshot; a resume must match it field for field
+static const char CHECKPOINT_MAGIC[8] = {'V', 'M', 'C', 'K', 'P', 'T', '0', '1'};
+struct CheckpointHeader {
+    char magic[8];
+    char algorithm[8];
+    uint64_t pageSize;
+    uint64_t numFrames;
+    uint64_t numPages;
+    uint64_t numBackingBlocks;
+    uint64_t traceSize;
+    int32_t workingSetWindow;
+    uint8_t options;            // -w, -f, -x
+    uint8_t prefetchPolicy;
+    uint8_t prefetchDegree;
+    uint8_t reserved;
+    int32_t lowWatermark;
+    int32_t highWatermark;
+    int32_t hugePageShift;
+    int32_t hugePromoteThreshold;
+    int32_t numaNodes;
+    uint8_t numaPlacement;
+    uint8_t numaPreferredNode;
+    uint8_t numaOptions;        // Local replacement, migration
+};
+
+// Structure representing one parsed trace record
+struct TraceRecord {
+    RecordKind kind = RECORD_SKIP;
+    char operation = 0;
+    unsigned long long memLocation = 0;
+    string_view text;         // Trimmed text line, for error messages
+    string_view memLocationStr;  // Address token as written, for error messages
+    unsigned short cpu = 0;      // --numa: CPU or node id written after the address
+};
+
+// Text traces are parsed ahead of the simulation in newline-aligned chunks of about this size
+const size_t PARSE_CHUNK_BYTES = 1 << 20;
+
+// Structure representing one parsed line of a chunk: page number instead of address, so the
+// simulation thread only replays it
+struct ChunkRecord {
+    long long pageNumber;
+    char operation;
+    RecordKind kind;
+    unsigned short cpu;
+};
+
+// One slot of the ring between the parse workers and the simulation thread. Chunk c uses slot
+// c % slots: a worker may fill it once freeFor reaches c and publishes it by setting parsed to c + 1.
+struct ParsedChunk {
+    atomic<size_t> freeFor{0};
+    atomic<size_t> parsed{0};
+    vector<ChunkRecord> records;
+    vector<TraceRecord> invalidRecords;  // Full records of the invalid lines, for their error messages
+};
+
+// Header of a binary trace: configuration followed by varint records.
+// Each record starts with a varint tag whose low two bits select its kind:
+//   0 read, 1 write: tag >> 2 is the zigzag delta from the previous address
+//   2 directive:     tag >> 2 is 0 print, 1 debug, 2 nodebug, 3 invalid reference
+//   3 long reference: tag >> 2 is the operation bit plus the CPU id shifted left by one,
+//                     the next varint is the zigzag delta
+// Fields are stored in host (little-endian) byte order.
+struct BinaryTraceHeader {
+    char magic[8];
+    uint64_t pageSize;
+    uint64_t numFrames;
+    uint64_t numPages;
+    uint64_t numBackingBlocks;
+};
+
+static const char BINARY_TRACE_MAGIC[8] = {'V', 'M', 'T', 'R', 'A', 'C', 'E', '1'};
+
+// Structure representing a parsed record in the buffer shared by ALL and sweep threads
+// (addresses rather than pages, since a sweep varies the page size)
+struct BufferedRecord {
+    unsigned long long memLocation;
+    char operation;
+    RecordKind kind;
+    unsigned short cpu;
+};
+
+// Replacement policies in ALL_ALGORITHMS order, resolved once from the algorithm name
+enum ReplacementPolicy : char {
+    POLICY_FIFO, POLICY_LRU, POLICY_OPTIMAL, POLICY_CLOCK, POLICY_ESC,
+    POLICY_ARC, POLICY_2Q, POLICY_LIRS, POLICY_WS, POLICY_WSCLOCK,
+    POLICY_ALL
+};
+
+// How --numa picks the node a faulting page is placed on, printed through NUMA_PLACEMENT_NAMES
+enum NumaPlacement : char {
+    NUMA_FIRST_TOUCH,   // The node of the CPU that made the reference
+    NUMA_INTERLEAVE,    // Page number modulo the node count
+    NUMA_PREFERRED      // --numa-preferred
+};
+
+static const char *const NUMA_PLACEMENT_NAMES[] = {"first-touch", "interleave", "preferred"};
+
+// Per-node --numa counters. Accesses and misses belong to the node of the referencing CPU,
+// placements and migrations to the node that received the page.
+struct NumaNodeCounters {
+    int accesses = 0;
+    int localAccesses = 0;
+    int remoteMisses = 0;
+    int pagesPlaced = 0;
+    int migrationsIn = 0;
+    int migrationReclaims = 0;   // Migrations that evicted a page on the target node to make room
+    int migrationsFailed = 0;
+};
+
+// Prefetchers run on every demand miss, selected with --prefetch
+enum PrefetchPolicy : char {
+    PREFETCH_NONE,
+    PREFETCH_NEXT,      // The next N pages after the missing one
+    PREFETCH_STRIDE,    // N pages along a stride seen twice in a row between misses
+    PREFETCH_HISTORY    // The pages that missed right after this page's earlier misses
+};
+
+static const char *const PREFETCH_NAMES[] = {"none", "next", "stride", "history"};
+
+// History prefetcher: a direct-mapped table from a missing page to its latest miss successors
+const int PREFETCH_HISTORY_ENTRIES = 1 << 12;
+const int PREFETCH_HISTORY_WAYS = 4;
+
+struct PrefetchHistoryEntry {
+    long long pageNumber = -1;
+    long long successors[PREFETCH_HISTORY_WAYS] = {-1, -1, -1, -1};  // Most recent first
+};
+
+// Structure describing one simulation over the shared records: policy and memory geometry
+struct SimulationConfig {
+    const char *algorithm;
+    size_t pageSize;
+    size_t frames;
+    size_t pages;
+    const int *nextUse;  // OPTIMAL lookahead built for this page size
+};
+
+// Structure holding the six counters DisplayResults reports
+struct SimulationCounters {
+    int references, mapped, misses, stolen, written, recovered;
+};
+
+// Synthetic reference patterns for --bench
+enum GeneratorKind : char {
+    GENERATOR_UNIFORM,     // Every page equally likely
+    GENERATOR_ZIPF,        // Zipfian hot set (theta 0.99) over the low pages
+    GENERATOR_SEQUENTIAL,  // Repeated scans of the whole address space
+    GENERATOR_LOOP,        // Loop over a working set 25% larger than memory
+    GENERATOR_PHASED,      // Alternating Zipfian phases (shifting hot set) and scans
+    GENERATOR_COUNT
+};
+
+static const char *const GENERATOR_NAMES[] = {"uniform", "zipf", "sequential", "loop", "phased"};
+
+// Structure holding one deterministic reference stream (splitmix64, so a seed replays exactly)
+struct TraceGenerator {
+    GeneratorKind kind;
+    uint64_t state;
+    size_t pages;
+    size_t loopPages;
+    size_t position;
+    long long generated;
+    long long phaseLength;
+    double zipfZetaN, zipfAlpha, zipfEta, zipfHalfPow;  // Gray et al. Zipfian sampling constants
+};
+
 // Global variables
 char *inputFilename = nullptr;
-char *replacementAlgorithm = nullptr;
+char *convertOutputFilename = nullptr;
 char *programName;
 
-static int debugMode = 0;
 static int totalBackingStoreBlocks = 0;
 bool backingStoreEnabled = false;
+bool debugRequested = false;  // -d on the command line, whatever the trace's debug lines do later
+bool wideAddresses = false;  // -x: 64-bit addresses on a sparse page table instead of % totalPages folding
+bool missRatioCurveMode = false;  // --mrc: one-pass LRU miss counts for every frame count
+double sampleRate = 0;            // --sample: SHARDS page sampling rate for --mrc, 0 for exact
+size_t sampleMaxPages = 0;        // --sample-max: cap on the sampled pages, lowering the rate, 0 for none
+vector<size_t> sweepFrameCounts;  // --frames: frame counts to sweep
+vector<size_t> sweepPageSizes;    // --page-size: page sizes to sweep
+int workingSetWindow = 1000;      // --tau: WS/WSCLOCK window in references of virtual time
+bool releaseRetiredPages = false; // -f: free the swap of pages the trace never references again
+bool benchmarkMode = false;       // --bench: time policies on generated traces instead of a file
+vector<size_t> benchPageCounts;   // --pages: table sizes to benchmark
+vector<bool> benchGenerators(GENERATOR_COUNT, false);  // --generator: patterns to run (all when none named)
+long long benchReferences = 1000000;  // --refs
+uint64_t benchSeed = 1;               // --seed
+bool benchScaling = false;            // --scaling: fail when a policy slows down on a 10M-page table
+double *benchCaseNanoseconds = nullptr;  // Shared with the forked case, which stores its ns/ref here
 
-size_t totalPages = 0, totalFrames = 0, pageSize = 0;
-int totalPageReferences = 0, totalPagesMapped = 0, totalPageMisses = 0;
-int totalFramesStolen = 0, totalFramesWrittenToDisk = 0, totalFramesRecoveredFromDisk = 0;
-map<int, char> pageOperationMap;
+// --scaling runs every case on a small table and on one a thousand times larger in frames and
+// 160 times larger in pages. Hits and evictions must cost the same at both sizes, so only the
+// page and frame tables falling out of cache may slow a case down, by at most this factor.
+const size_t SCALING_PAGES[2] = {65536, 10485760};
+const size_t SCALING_FRAMES[2] = {64, 65536};
+const double SCALING_MAX_SLOWDOWN = 8.0;
+int intervalLength = 0;                 // --interval: references per time-series row, 0 for none
+bool intervalNdjson = false;            // --interval-format ndjson instead of csv
+const char *intervalFilename = nullptr; // --interval-file: rows go here instead of the report
+int intervalFd = -1;
+long long intervalFileLength = -1;      // Bytes of the interval file the latest snapshot covers
+size_t checkpointInterval = 0;          // --checkpoint-every: trace records between snapshots, 0 for none
+string checkpointFilename;              // --checkpoint-file, default <trace>.checkpoint
+const char *resumeFilename = nullptr;   // --resume: snapshot to continue from
+pid_t checkpointWriter = -1;            // Forked child still writing the latest snapshot
+PrefetchPolicy prefetchPolicy = PREFETCH_NONE;  // --prefetch
+int prefetchDegree = 4;                 // --prefetch-degree: pages fetched ahead per miss
+size_t lowWatermark = 0, highWatermark = 0;  // --watermarks: free frames that wake and satisfy the page-out daemon
+int hugePageShift = 0;                  // --huge-pages: log2 of the base pages per huge page, 0 for base pages only
+int hugePromoteThreshold = 50;          // --huge-threshold: percent of a region resident before it is promoted
+int numaNodes = 0;                      // --numa: memory nodes the frame table is split into, 0 for one pool
+NumaPlacement numaPlacement = NUMA_FIRST_TOUCH;  // --numa-placement
+int numaPreferredNode = 0;              // --numa-preferred
+bool numaLocalReplacement = false;      // --numa-replacement local: victims come from the node the page goes to
+bool numaMigrate = false;               // --numa-migrate: move pages toward the node that keeps referencing them
+int parseThreads = -1;                  // --parse-threads: text trace parsing workers, -1 to size automatically
+
+static const char *const ALL_ALGORITHMS[] = {"FIFO", "LRU", "OPTIMAL", "CLOCK", "ESC", "ARC", "2Q", "LIRS", "WS", "WSCLOCK"};
 
 string initialConfigLine;
-bool isInitialConfigPrinted = false;
 
-BackingStoreBlock *backingStoreTable = nullptr;
-int backingStoreBlocksInUse = 0;
-int backingStoreBlocksRead = 0;
-int backingStoreBlocksWritten = 0;
+// Per-simulation state below is thread_local, so ALL and sweeps can run simulations on their own threads
+thread_local size_t totalPages = 0, totalFrames = 0, pageSize = 0;
+thread_local const char *replacementAlgorithm = nullptr;
+thread_local ReplacementPolicy replacementPolicy = POLICY_ALL;  // replacementAlgorithm, resolved
+static thread_local int debugMode = 0;
+thread_local ostream *reportOutput = &cout;  // Where this simulation's reports go
+
+thread_local int totalPageReferences = 0, totalPagesMapped = 0, totalPageMisses = 0;
+thread_local int totalFramesStolen = 0, totalFramesWrittenToDisk = 0, totalFramesRecoveredFromDisk = 0;
+
+thread_local bool isInitialConfigPrinted = false;
+
+thread_local BackingStoreBlock *backingStoreTable = nullptr;
+thread_local int backingStoreBlocksInUse = 0;
+thread_local int backingStoreBlocksRead = 0;
+thread_local int backingStoreBlocksWritten = 0;
+thread_local int backingStoreBlocksReleased = 0, backingStoreBlocksReused = 0, backingStoreBlocksPeak = 0;
+thread_local int retiredPageWritesAvoided = 0;
+
+// Hierarchical free bitmap over the backing store: a set bit in level 0 marks a free block, and a
+// set bit in level k marks a level k-1 word that still has a free block. The top level is one word.
+thread_local vector<vector<uint64_t>> freeBlockBitmap;
+
+// Backing store block of each page (-1 for none), kept out of the page table entries
+thread_local vector<int> pageBackingStoreBlock;
+thread_local unordered_map<long long, int> sparsePageBackingStoreBlock;
+
+// Swap file backend (--swap-file, with -w): backing store block i is block i of a real file,
+// and every swap-out and swap-in the bookkeeping counts is issued as O_DIRECT I/O on a pool of
+// threads. Blocks map to threads by index, so the requests for one block complete in order.
+const size_t SWAP_QUEUE_DEPTH = 64;      // Requests a thread holds before the simulation waits
+const int SWAP_LATENCY_BUCKETS = 32;     // Powers of two of microseconds
+
+struct SwapRequest {
+    bool isWrite;
+    int block;
+    long long pageNumber;                // Stamped into a written block and checked on reading it back
+    chrono::steady_clock::time_point submitted;
+};
+
+// Submission-to-completion latency, queueing included
+struct SwapLatency {
+    long long count = 0;
+    double totalMicroseconds = 0;
+    long long buckets[SWAP_LATENCY_BUCKETS] = {};  // Bucket b: [2^(b-1), 2^b) us, bucket 0 under 1 us
+};
+
+struct SwapWorker {
+    thread worker;
+    mutex lock;
+    condition_variable changed;
+    deque<SwapRequest> queue;
+    bool stopping = false;
+    void *buffer = nullptr;              // One block, aligned for O_DIRECT
+    SwapLatency latency[2];              // Swap-in, swap-out
+    long long verifyFailures = 0;
+};
+
+const char *swapFilename = nullptr;      // --swap-file
+int swapThreads = 4;                     // --swap-threads
+int swapFd = -1;
+bool swapDirect = false;                 // False when the file system refused O_DIRECT
+size_t swapBlockSize = 0;
+SwapWorker *swapWorkers = nullptr;
+SwapLatency swapLatency[2];              // Merged from the workers once they finish
+long long swapVerifyFailures = 0;
+
+// Sparse page table for 64-bit addresses: a radix tree of 512-way nodes, as in an x86-64
+// page table. It grows taller as larger page numbers appear and only allocates touched paths.
+const int RADIX_BITS = 9;
+const int RADIX_FANOUT = 1 << RADIX_BITS;
+
+struct RadixNode {
+    void *slots[RADIX_FANOUT] = {};  // RadixNode one level down, or PageLeaf at the bottom
+};
+
+struct PageLeaf {
+    Page entries[RADIX_FANOUT];
+    uint64_t pollutedBits[RADIX_FANOUT / 64] = {};  // --prefetch pollution marks, as in pollutedPageBits
+};
+
+thread_local void *radixRoot = nullptr;
+thread_local int radixHeight = 0;             // Levels including the leaf level, 0 while empty
+thread_local size_t radixNodesAllocated = 0;
+thread_local PageLeaf *cachedLeaf = nullptr;  // Last leaf walked to, so repeated lookups skip the tree
+thread_local long long cachedLeafBase = -1;
+
+// Heap allocations made by this thread, and those made while simulating references (reported under -d)
+static thread_local size_t heapAllocationCount = 0;
+thread_local size_t referenceHeapAllocations = 0;
+
+// Input trace, mapped in place (or read into one buffer when it cannot be mapped)
+const char *traceData = nullptr;
+size_t traceSize = 0;
+size_t traceBodyOffset = 0;  // First byte after the configuration line
+bool traceIsMapped = false;
+bool binaryTrace = false;
+vector<char> traceBuffer;
+
+// Records parsed once and replayed by every policy thread in ALL mode
+vector<BufferedRecord> sharedRecords;
+
+// LRU stack distances in O(log n) per reference (Mattson's stack algorithm). Every page keeps one
+// marker in a Fenwick tree at the slot of its latest access, so the markers after a page's slot
+// count the distinct pages touched since. Slots are renumbered when they run out, which keeps
+// memory proportional to the pages seen rather than the length of the trace.
+struct StackDistanceTracker {
+    vector<int> fenwick;                         // 1-based Fenwick tree over slots
+    vector<long long> slotPage;                  // Page whose latest access is in a slot, -1 if stale
+    vector<long long> denseLastSlot;             // Latest slot per page when pages can index a vector
+    unordered_map<long long, long long> sparseLastSlot;
+    size_t nextSlot = 0;
+    size_t activePages = 0;
+    bool dense = false;
+
+    void Initialize(bool useDenseTable, size_t pageCount) {
+        dense = useDenseTable;
+        if (dense) {
+            denseLastSlot.assign(pageCount, -1);
+        }
+        fenwick.assign(1025, 0);
+        slotPage.assign(1024, -1);
+    }
+
+    long long &LastSlot(long long page) {
+        return dense ? denseLastSlot[page] : sparseLastSlot.emplace(page, -1).first->second;
+    }
+
+    void Add(size_t slot, int delta) {
+        for (size_t i = slot + 1; i < fenwick.size(); i += i & (0 - i)) {
+            fenwick[i] += delta;
+        }
+    }
+
+    // Number of markers in slots [0, slot)
+    long long PrefixSum(size_t slot) {
+        long long sum = 0;
+        for (size_t i = slot; i > 0; i -= i & (0 - i)) {
+            sum += fenwick[i];
+        }
+        return sum;
+    }
+
+    // Renumber the live markers to the front, growing the slot space if it is over half full
+    void Compact() {
+        size_t capacity = slotPage.size();
+        if (activePages * 2 > capacity) {
+            capacity *= 2;
+        }
+
+        vector<long long> packed(capacity, -1);
+        size_t liveSlots = 0;
+        for (size_t slot = 0; slot < nextSlot; slot++) {
+            if (slotPage[slot] != -1) {
+                packed[liveSlots] = slotPage[slot];
+                LastSlot(slotPage[slot]) = liveSlots;
+                liveSlots++;
+            }
+        }
+        slotPage.swap(packed);
+        nextSlot = liveSlots;
+
+        // Linear-time Fenwick build over the packed markers
+        fenwick.assign(capacity + 1, 0);
+        for (size_t i = 1; i <= capacity; i++) {
+            fenwick[i] += i <= liveSlots ? 1 : 0;
+            size_t parent = i + (i & (0 - i));
+            if (parent <= capacity) {
+                fenwick[parent] += fenwick[i];
+            }
+        }
+    }
 
-vector<string> inputLines;
+    // Record an access and return its stack distance (1 = most recent page), or 0 on first use
+    long long Access(long long page) {
+        long long distance = 0;
+        long long previousSlot = LastSlot(page);
+        if (previousSlot != -1) {
+            distance = activePages - PrefixSum(previousSlot + 1) + 1;
+            Add(previousSlot, -1);
+            slotPage[previousSlot] = -1;
+            activePages--;
+        }
+
+        if (nextSlot == slotPage.size()) {
+            Compact();
+        }
+        Add(nextSlot, 1);
+        slotPage[nextSlot] = page;
+        LastSlot(page) = nextSlot;
+        nextSlot++;
+        activePages++;
+        return distance;
+    }
+
+    // Forget a page, as if it had never been accessed
+    void Remove(long long page) {
+        long long slot = LastSlot(page);
+        Add(slot, -1);
+        slotPage[slot] = -1;
+        activePages--;
+        if (dense) {
+            denseLastSlot[page] = -1;
+        } else {
+            sparseLastSlot.erase(page);
+        }
+    }
+};
+
+// Lowest frame index that may still be unused
+thread_local size_t nextUnusedFrame = 0;
+
+// For FIFO, LRU and WS: intrusive list threaded through the frame table, in load order for
+// FIFO (hits do not move a frame) and in recency order otherwise
+thread_local int leastRecentFrame = -1;
+thread_local int mostRecentFrame = -1;
+
+// For OPTIMAL algorithm: line of the next reference to the same page, for every line
+// (a shared, read-only table for this page size), and an indexed max-heap of resident
+// frames keyed by the next use of their page
+thread_local const int *nextUseLine = nullptr;
+thread_local vector<int> optimalHeap;
+thread_local vector<int> optimalHeapPosition;
+thread_local vector<int> frameNextUse;
+
+// For CLOCK and ESC (enhanced second chance) algorithms: the rotating hand and its sweep statistics
+thread_local size_t clockHand = 0;
+thread_local int clockHandAdvances = 0;     // Frames the hand moved past
+thread_local int clockHandRevolutions = 0;  // Times the hand wrapped to frame 0
+thread_local int clockReferenceBitsCleared = 0;
+thread_local int clockDirtyFramesSkipped = 0;
+thread_local int clockCleanVictims = 0, clockDirtyVictims = 0;
+
+// For WS and WSCLOCK algorithms: frames released by working-set trimming, and the exact
+// working-set size W(t, tau) tracked through a ring of the last tau references
+thread_local vector<int> freeFrames;
+thread_local int workingSetTrims = 0;
+thread_local int workingSetFramesSkipped = 0, workingSetCleaningWrites = 0;
+thread_local vector<long long> workingSetRing;
+thread_local vector<int> pageLastReference;
+thread_local unordered_map<long long, int> sparsePageLastReference;
+thread_local int workingSetTime = 0;
+thread_local size_t workingSetSize = 0, workingSetPeak = 0;
+thread_local long long workingSetSizeSum = 0, workingSetSamples = 0;
+
+// For --prefetch: the prefetcher's own state, and one bit per page set when a prefetch fill
+// evicted it while it was neither prefetched nor referenced again yet (a later miss on one is
+// pollution). Under -x the bits live in the radix leaves instead.
+thread_local bool prefetchActive = false;
+thread_local int prefetchesIssued = 0, prefetchesUsed = 0, prefetchesEvictedUnused = 0;
+thread_local int prefetchPollutionMisses = 0, prefetchSwapReads = 0;
+thread_local long long strideLastMiss = -1, strideLastDelta = 0;
+thread_local long long historyLastMiss = -1;
+thread_local vector<PrefetchHistoryEntry> prefetchHistory;
+thread_local vector<uint64_t> pollutedPageBits;
+
+// For --watermarks: frames holding a page (the rest are free), and what the page-out daemon did.
+// Extra writes are cleanings undone by a later write to the page before it was evicted.
+thread_local size_t framesInUse = 0;
+thread_local bool pageOutActive = false;
+thread_local int pageOutWakeups = 0, pageOutReclaims = 0, pageOutReclaimWrites = 0;
+thread_local int pageOutCleanings = 0, pageOutExtraWrites = 0;
+thread_local vector<int> pageOutCandidates;
 
-// For OPTIMAL algorithm optimization
-unordered_map<int, vector<int>> futurePageReferences;
+// For --huge-pages: one word per huge-page-aligned region of base pages, holding how many of
+// them are resident plus REGION_PROMOTED while the region is mapped as a huge page. Untouched
+// frames are promotion fills the trace has not referenced, the huge pages' internal fragmentation.
+const int REGION_PROMOTED = 1 << 30;
+thread_local bool hugePagesActive = false;
+thread_local vector<int> regionState;
+thread_local unordered_map<long long, int> sparseRegionState;
+thread_local int hugePromotions = 0, hugePromotionsDeferred = 0, hugeDemotions = 0, hugePagesMapped = 0;
+thread_local int hugePageReferences = 0;
+thread_local int hugeFillFrames = 0, hugeFillSwapReads = 0, hugeFillsEvictedUntouched = 0;
+thread_local int hugeUntouchedFrames = 0, hugeUntouchedPeak = 0;
+
+// For --numa: the node of the CPU making the current reference, the node placement chose for
+// the page being loaded, and the node a victim must come from (-1 for any). Each node's frames
+// are one contiguous run of the frame table with its own free pool.
+thread_local bool numaActive = false;
+thread_local bool numaNodeLocal = false;   // Node-local replacement, which ARC, 2Q and LIRS do not support
+thread_local int accessNode = 0;
+thread_local int numaTargetNode = 0;
+thread_local int victimNode = -1;
+thread_local vector<vector<int>> nodeFreeFrames;
+thread_local vector<size_t> nodeNextUnusedFrame;
+thread_local vector<NumaNodeCounters> numaCounters;
+
+// For --interval: a row buffer flushed in whole rows, the counters at the start of the window,
+// and a per-page stamp of the last window that touched the page (to count distinct pages)
+const size_t INTERVAL_BUFFER_SIZE = 1 << 16;
+const size_t INTERVAL_MAX_ROW = 256;
+thread_local char intervalBuffer[INTERVAL_BUFFER_SIZE];
+thread_local size_t intervalBufferUsed = 0;
+thread_local SimulationCounters intervalStart;
+thread_local int intervalIndex = 0;
+thread_local int intervalDistinctPages = 0;
+thread_local vector<int> pageLastInterval;
+thread_local unordered_map<long long, int> sparsePageLastInterval;
+
+// For ARC, 2Q and LIRS algorithms: every tracked page, resident or ghost, is a node in an
+// arena. A node sits in up to two lists at once (LIRS keeps pages on both its stack and its
+// queue) and is found by page number through a dense directory, or a hash map with -x.
+enum PolicyListId : signed char {
+    LIST_NONE = -1,
+    ARC_T1, ARC_T2, ARC_B1, ARC_B2,      // Link set 0
+    TWOQ_A1IN, TWOQ_A1OUT, TWOQ_AM,      // Link set 0
+    LIRS_STACK,                          // Link set 0
+    LIRS_QUEUE, LIRS_NONRESIDENT,        // Link set 1
+    POLICY_LIST_COUNT
+};
+
+struct PolicyNode {
+    long long pageNumber = -1;
+    int frame = -1;                          // -1 while the page is a ghost
+    int prev[2] = {-1, -1};
+    int next[2] = {-1, -1};
+    PolicyListId list[2] = {LIST_NONE, LIST_NONE};
+    bool isLir = false;
+};
+
+// Lists run from the oldest (LRU) entry at the head to the newest at the tail
+struct PolicyList {
+    int head = -1;
+    int tail = -1;
+    size_t size = 0;
+};
+
+thread_local vector<PolicyNode> policyNodes;
+thread_local vector<int> freePolicyNodes;
+thread_local PolicyList policyLists[POLICY_LIST_COUNT];
+thread_local vector<int> policyNodeOfPage;
+thread_local unordered_map<long long, int> sparsePolicyNodeOfPage;
+thread_local size_t arcTargetT1 = 0;                  // ARC's adaptive p
+thread_local size_t twoQueueKin = 0, twoQueueKout = 0;
+thread_local size_t lirsLirLimit = 0, lirsLirCount = 0;
+thread_local int pinnedPolicyNode = -1;               // The demand page while its prefetches pick victims
 
 // Function declarations
 void DisplayResults(Page *pageTable, Frame *frameTable, bool isFinalReport = false);
-int SelectFrameForReplacement(Frame *frameTable);
-int FindAvailableFrame(Frame *frameTable);
+int SelectFrameForReplacement(long long currentPage, Page *pageTable, Frame *frameTable);
+int FindAvailableFrame(long long pageNumber, Frame *frameTable);
+int FindNodeFrame(int node, Frame *frameTable);
+void ReleaseFrame(int frameIndex, Frame *frameTable);
+int FrameNode(size_t frameIndex);
+size_t NodeFirstFrame(int node);
+void TrackNodeAccess(int selectedFrame, bool isCacheHit, Page *pageTable, Frame *frameTable);
+void MoveFrame(int from, int to, Page *pageTable, Frame *frameTable);
+void IssuePrefetches(long long currentPage, Page *pageTable, Frame *frameTable);
+bool SupportsPageOutDaemon();
+void RunPageOutDaemon(Page *pageTable, Frame *frameTable);
+int ReclaimFrame(Page *pageTable, Frame *frameTable);
+void CleanFrame(int frameIndex, Page *pageTable, Frame *frameTable);
+bool PrefetchPage(long long pageNumber, Page *pageTable, Frame *frameTable);
+bool LoadUnreferencedPage(long long pageNumber, int selectedFrame, Page *pageTable, Frame *frameTable);
+int &HugeRegionSlot(long long region);
+void PromoteHugeRegion(long long region, Page *pageTable, Frame *frameTable);
+void ReleaseHugeRegionPage(long long pageNumber, Frame &frame);
 static void ShowUsage();
 int FindAvailableBackingStoreBlock();
-void ProcessInputLine(string line, size_t lineNumber, Page *pageTable, Frame *frameTable);
+void MarkBackingStoreBlock(int block, bool isFree);
+void ReleaseBackingStoreBlock(long long pageNumber, Page &page);
+int BackingStoreBlockOf(long long pageNumber);
+void SetBackingStoreBlock(long long pageNumber, int block);
+void ProcessInputLine(string_view line, size_t lineNumber, Page *pageTable, Frame *frameTable);
+void ProcessTraceRecord(const TraceRecord &record, size_t lineNumber, Page *pageTable, Frame *frameTable);
+void SimulateRecord(RecordKind kind, char operation, long long currentPage, unsigned cpu, size_t lineNumber, Page *pageTable, Frame *frameTable);
+void ProcessPageReference(char operation, long long currentPage, size_t lineNumber, Page *pageTable, Frame *frameTable);
+TraceRecord ParseInputLine(string_view line);
+RecordKind ParseHexLocation(string_view token, unsigned long long &value);
+void ReportInvalidRecord(const TraceRecord &record, size_t lineNumber);
+long long PageNumberFor(unsigned long long memLocation);
+inline Page &PageEntry(Page *pageTable, long long pageNumber);
+inline uint64_t &PollutionWord(long long pageNumber);
+Page &SparsePageEntry(long long pageNumber);
+void DisplayPageEntry(long long pageNumber, const Page &page);
+void DisplaySparsePageTable(void *node, int level, long long basePage);
+void ReleaseSparsePageTable(void *node, int level);
 void InitializeBackingStore();
-void AnalyzeFuturePageReferences();
+void OpenSwapFile();
+void SubmitSwapIo(bool isWrite, int block, long long pageNumber);
+void RunSwapWorker(SwapWorker *worker);
+void CloseSwapFile();
+void DisplaySwapStatistics(ostream &out);
+void InitializeReplacementState();
+void ResetSimulationState();
+void AnalyzeFuturePageReferences(vector<int> &nextUse, bool fromSharedRecords);
+void BufferTraceRecords();
+void RunAllAlgorithms();
+void RunParameterSweep();
+SimulationCounters RunSimulation(const SimulationConfig &config, int startDebugMode, ostream *output);
+void BeginSimulation(const SimulationConfig &config, int startDebugMode, ostream *output, Page *&pageTable, Frame *&frameTable);
+ReplacementPolicy ResolveReplacementPolicy(const char *algorithm);
+void RunBenchmark();
+void InitializeIntervals();
+void TrackIntervalPage(long long currentPage);
+void EmitIntervalRow();
+void FinishIntervals();
+void FlushIntervalRows();
+void TruncateIntervalFile(long long length);
+void RunBenchmarkCase(const char *algorithm, const TraceGenerator &prototype, size_t frames);
+void InitializeGenerator(TraceGenerator &generator, GeneratorKind kind, size_t pages, size_t frames);
+void NextGeneratedReference(TraceGenerator &generator, char &operation, unsigned long long &memLocation);
+bool ParseSweepList(const char *spec, vector<size_t> &values);
+void RunMissRatioCurve();
+void RunSampledMissRatioCurve();
 void DisplayInitialConfiguration();
-void ExecutePageReplacement(int currentPage, int &selectedFrame, Page *pageTable, Frame *frameTable);
-void UpdateFrameAndPageEntries(int currentPage, int selectedFrame, char operation, Page *pageTable, Frame *frameTable, bool isCacheHit);
-void HandlePageLoadingFromDisk(int currentPage, bool isCacheHit, Page *pageTable);
+void ExecutePageReplacement(long long currentPage, int &selectedFrame, Page *pageTable, Frame *frameTable);
+void UpdateFrameAndPageEntries(long long currentPage, int selectedFrame, char operation, Page *pageTable, Frame *frameTable, bool isCacheHit);
+void HandlePageLoadingFromDisk(long long currentPage, bool isCacheHit, Page *pageTable);
+void PromoteFrameToMostRecent(int frameIndex, Frame *frameTable);
+void UnlinkRecentFrame(int frameIndex, Frame *frameTable);
+void StealFrame(int selectedFrame, Page *pageTable, Frame *frameTable);
+void WritePageToBackingStore(long long pageNumber, Page &page);
+bool IsClockAlgorithm();
+int AdvanceClockHand(Page *pageTable, Frame *frameTable);
+bool IsWorkingSetAlgorithm();
+void TrackWorkingSet(long long currentPage);
+void TrimWorkingSet(Page *pageTable, Frame *frameTable);
+bool IsAdaptiveAlgorithm();
+int &PolicyDirectorySlot(long long pageNumber);
+int CreatePolicyNode(long long pageNumber);
+void ReleasePolicyNode(int node);
+void PolicyListAppend(PolicyListId id, int node);
+void PolicyListRemove(int node, int linkSet);
+int SelectAdaptiveVictim(long long currentPage);
+int UnpinnedListHead(PolicyListId id);
+void UpdateAdaptivePolicy(long long currentPage, int selectedFrame, bool isCacheHit);
+void LirsMakeLir(int node);
+void LirsPruneStack();
+void UpdateOptimalHeap(int frameIndex, int nextUse);
 void ParseCommandLineArguments(int argc, char *argv[]);
 void LoadInputFile();
-void ProcessAllInputLines(Page *pageTable, Frame *frameTable);
+bool NextTraceLine(size_t &offset, string_view &line);
+bool NextBinaryRecord(size_t &offset, long long &previousAddress, TraceRecord &record);
+bool NextTraceRecord(size_t &offset, long long &previousAddress, TraceRecord &record);
+void ConvertTraceToBinary();
+void ProcessAllInputLines(TracePosition position, Page *pageTable, Frame *frameTable);
+size_t TraceChunkStart(size_t baseOffset, size_t chunk);
+void ParseTraceChunks(size_t baseOffset, size_t chunkCount, vector<ParsedChunk> &slots, atomic<size_t> &nextChunk,
+                      size_t parserPageSize, size_t parserPages);
+void ProcessChunkedInputLines(TracePosition position, int workerCount, Page *pageTable, Frame *frameTable);
+void BuildCheckpointHeader(CheckpointHeader &header);
+void WriteCheckpoint(const TracePosition &position, Page *pageTable, Frame *frameTable);
+bool SaveCheckpoint(const TracePosition &position, Page *pageTable, Frame *frameTable);
+void WaitForCheckpointWriter();
+void LoadCheckpoint(TracePosition &position, Page *pageTable, Frame *frameTable);
+void SaveSparsePageTable(ostream &out, void *node, int level, long long basePage);
 void ReleaseResources(Page *pageTable, Frame *frameTable);
+void ReleaseTrace();
 
 // Main function
 int main(int argc, char *argv[]) {
@@ -89,524 +792,4054 @@ int main(int argc, char *argv[]) {
 
     ParseCommandLineArguments(argc, argv);
 
+    // Interval rows from every simulation share one file, opened for appending whole rows. A
+    // resume keeps the rows before its snapshot, so LoadCheckpoint cuts the file back instead.
+    if (intervalFilename) {
+        intervalFd = open(intervalFilename, O_WRONLY | O_CREAT | O_APPEND, 0644);
+        if (intervalFd == -1) {
+            cerr << "Error: Unable to create interval file " << intervalFilename << endl;
+            exit(1);
+        }
+        if (!resumeFilename) {
+            TruncateIntervalFile(0);
+        }
+    }
+
+    // Benchmarks generate their own references and never read a trace
+    if (benchmarkMode) {
+        RunBenchmark();
+        return 0;
+    }
+
     LoadInputFile();
 
+    // Conversion mode writes the binary trace and stops
+    if (convertOutputFilename) {
+        ConvertTraceToBinary();
+        ReleaseTrace();
+        return 0;
+    }
+
+    // --mrc replaces the simulation with one stack-distance pass, over a sample with --sample
+    if (missRatioCurveMode) {
+        if (sampleRate > 0 || sampleMaxPages > 0) {
+            RunSampledMissRatioCurve();
+        } else {
+            RunMissRatioCurve();
+        }
+        ReleaseTrace();
+        return 0;
+    }
+
+    // Sweeps parse once and fan the configurations out over a thread pool
+    if (!sweepFrameCounts.empty() || !sweepPageSizes.empty()) {
+        RunParameterSweep();
+        ReleaseTrace();
+        return 0;
+    }
+
+    // ALL parses once and runs every policy on its own thread
+    if (replacementPolicy == POLICY_ALL) {
+        RunAllAlgorithms();
+        ReleaseTrace();
+        return 0;
+    }
+
+    if (lowWatermark && highWatermark >= totalFrames) {
+        cerr << "Error: The high watermark must be below the number of frames." << endl;
+        exit(1);
+    }
+
     InitializeBackingStore();
+    if (swapFilename) {
+        OpenSwapFile();
+    }
 
-    Page *pageTable = new Page[totalPages];
+    // 64-bit mode populates its radix table lazily instead
+    Page *pageTable = wideAddresses ? nullptr : new Page[totalPages];
     Frame *frameTable = new Frame[totalFrames];
 
-    AnalyzeFuturePageReferences();
+    vector<int> nextUseTable;
+    if (replacementPolicy == POLICY_OPTIMAL || releaseRetiredPages) {
+        AnalyzeFuturePageReferences(nextUseTable, false);
+        nextUseLine = nextUseTable.data();
+    }
+
+    InitializeReplacementState();
+    InitializeIntervals();
+
+    // A resume overwrites the fresh state with the snapshot's and skips the records it covered
+    TracePosition position = {traceBodyOffset, 0, 0};
+    if (resumeFilename) {
+        LoadCheckpoint(position, pageTable, frameTable);
+    }
 
     DisplayInitialConfiguration();
+    if (resumeFilename) {
+        cout << "Resumed from " << resumeFilename << " at trace record " << position.recordIndex << endl;
+    }
 
-    ProcessAllInputLines(pageTable, frameTable);
+    ProcessAllInputLines(position, pageTable, frameTable);
+    WaitForCheckpointWriter();
 
-    // Print final results
+    // Print final results once the swap file has caught up
+    FinishIntervals();
+    if (swapFilename) {
+        CloseSwapFile();
+    }
     DisplayResults(pageTable, frameTable, true);
+    if (debugRequested) {
+        cout << "Heap allocations while simulating references: " << referenceHeapAllocations << endl;
+    }
 
     ReleaseResources(pageTable, frameTable);
+    ReleaseTrace();
 
     return 0;
 }
 
-void InitializeBackingStore() {
-    // Initialize backing store if enabled
-    if (backingStoreEnabled && totalBackingStoreBlocks > 0) {
-        backingStoreTable = new BackingStoreBlock[totalBackingStoreBlocks];
+// Function to compute LRU misses for every frame count from 1 to the configured number of frames
+void RunMissRatioCurve() {
+    DisplayInitialConfiguration();
+
+    StackDistanceTracker tracker;
+    tracker.Initialize(!wideAddresses, totalPages);
+
+    // distanceCounts[d] for d = 1..totalFrames, with distanceCounts[totalFrames + 1] for anything deeper
+    vector<long long> distanceCounts(totalFrames + 2, 0);
+    long long simulatedReferences = 0, coldMisses = 0;
+
+    size_t offset = traceBodyOffset;
+    long long previousAddress = 0;
+    TraceRecord record;
+    for (size_t lineIndex = 0; NextTraceRecord(offset, previousAddress, record); lineIndex++) {
+        if (record.kind == RECORD_SKIP || record.kind == RECORD_PRINT ||
+            record.kind == RECORD_DEBUG || record.kind == RECORD_NODEBUG) continue;
+
+        // Invalid lines still count as references, as in the simulation
+        totalPageReferences++;
+        if (record.kind != RECORD_REFERENCE) {
+            if (!binaryTrace) {
+                ReportInvalidRecord(record, lineIndex);
+            }
+            continue;
+        }
+
+        simulatedReferences++;
+        long long distance = tracker.Access(PageNumberFor(record.memLocation));
+        if (distance == 0) {
+            coldMisses++;
+        } else {
+            distanceCounts[min<long long>(distance, totalFrames + 1)]++;
+        }
+    }
+    totalPagesMapped = coldMisses;
+
+    cout << "Pages referenced: " << totalPageReferences << '\n'
+         << "Pages mapped: " << totalPagesMapped << '\n';
+
+    // LRU with F frames misses on first use and on every reuse deeper than F
+    cout << "Miss ratio curve" << '\n';
+    long long misses = simulatedReferences;
+    for (size_t frames = 1; frames <= totalFrames; frames++) {
+        misses -= distanceCounts[frames];
+        cout << setw(5) << frames << " misses:" << misses << " ratio:" << fixed << setprecision(4)
+             << (simulatedReferences ? double(misses) / simulatedReferences : 0.0) << '\n';
+    }
+
+    cout << "Reuse distance histogram" << '\n';
+    for (size_t distance = 1; distance <= totalFrames; distance++) {
+        cout << setw(5) << distance << " count:" << distanceCounts[distance] << '\n';
     }
+    cout << setw(5) << ">" + to_string(totalFrames) << " count:" << distanceCounts[totalFrames + 1] << '\n'
+         << setw(5) << "cold" << " count:" << coldMisses << endl;
 }
 
-void AnalyzeFuturePageReferences() {
-    // Preprocess future page references for OPTIMAL algorithm
-    if (strcmp(replacementAlgorithm, "OPTIMAL") == 0) {
-        unordered_map<int, vector<int>> pageUses;
-        for (size_t lineIndex = 0; lineIndex < inputLines.size(); lineIndex++) {
-            string line = inputLines[lineIndex];
+// Function to estimate the LRU miss ratio curve from a spatially hashed sample of the pages
+// (SHARDS, Waldspurger et al.). A page is kept when its hash falls under rate * 2^24, so every
+// reference to it is kept too; the other pages in a sampled stack distance scale by 1 / rate. Memory grows with the
+// sampled pages only, and --sample-max bounds it: once the sample holds more pages than that, the
+// page with the largest hash is dropped, the threshold falls to its hash, and the counts so far
+// are rescaled to the lower rate (fixed-size SHARDS). Halving the hash range gives two
+// independent half-rate samples whose disagreement estimates the error.
+void RunSampledMissRatioCurve() {
+    DisplayInitialConfiguration();
 
-            // Skip comments and empty lines
-            if (line.empty() || line[0] == '#') continue;
+    const uint64_t HASH_RANGE = 1 << 24;
+    const uint64_t threshold = sampleRate > 0 ? max<uint64_t>(2, llround(sampleRate * HASH_RANGE)) : HASH_RANGE;
+    uint64_t sampleThresholds[3][2] = {{0, threshold}, {0, threshold / 2}, {threshold / 2, threshold}};
+    const size_t samplePageCaps[3] = {sampleMaxPages, sampleMaxPages / 2, sampleMaxPages / 2};
 
-            // Trim leading/trailing whitespace
-            line.erase(0, line.find_first_not_of(" \t\r\n"));
-            line.erase(line.find_last_not_of(" \t\r\n") + 1);
+    // Sample 0 is the whole sample, samples 1 and 2 its two halves. With --sample-max each keeps
+    // a max-heap of its pages by hash to find the next one to drop.
+    StackDistanceTracker trackers[3];
+    vector<double> distanceCounts[3];
+    vector<pair<uint64_t, long long>> sampledPages[3];
+    long long sampledReferences[3] = {0, 0, 0};
 
-            // Skip commands
-            if (line == "print" || line == "debug" || line == "nodebug") continue;
+    // Rescaling the counts on every drop would cost a pass over them, so later references weigh
+    // more instead, and the counts are divided down once at the end
+    double sampledWeight[3] = {0, 0, 0}, referenceWeight[3] = {1, 1, 1};
+    for (int i = 0; i < 3; i++) {
+        trackers[i].Initialize(false, 0);
+        distanceCounts[i].assign(totalFrames + 2, 0);
+        sampledPages[i].reserve(samplePageCaps[i] + 1);
+    }
+    long long simulatedReferences = 0;
 
-            // Parse operation and memory location
-            istringstream iss(line);
-            char operation;
-            string memLocationStr;
+    size_t offset = traceBodyOffset;
+    long long previousAddress = 0;
+    TraceRecord record;
+    for (size_t lineIndex = 0; NextTraceRecord(offset, previousAddress, record); lineIndex++) {
+        if (record.kind == RECORD_SKIP || record.kind == RECORD_PRINT ||
+            record.kind == RECORD_DEBUG || record.kind == RECORD_NODEBUG) continue;
 
-            if (!(iss >> operation >> memLocationStr)) {
-                continue; // Skip invalid lines
+        totalPageReferences++;
+        if (record.kind != RECORD_REFERENCE) {
+            if (!binaryTrace) {
+                ReportInvalidRecord(record, lineIndex);
             }
+            continue;
+        }
+        simulatedReferences++;
 
-            // Parse memory location (supporting hexadecimal without '0x' prefix)
-            int memLocation;
-            try {
-                memLocation = stoi(memLocationStr, nullptr, 16); // Base 16 for hexadecimal
-            } catch (...) {
+        // splitmix64's finalizer spreads neighbouring page numbers over the hash range
+        long long page = PageNumberFor(record.memLocation);
+        uint64_t hash = page;
+        hash = (hash ^ (hash >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        hash = (hash ^ (hash >> 27)) * 0x94D049BB133111EBULL;
+        hash = (hash ^ (hash >> 31)) % HASH_RANGE;
+        if (hash >= threshold) continue;
+
+        for (int i = 0; i < 3; i++) {
+            if (hash < sampleThresholds[i][0] || hash >= sampleThresholds[i][1]) continue;
+            double rate = double(sampleThresholds[i][1] - sampleThresholds[i][0]) / HASH_RANGE;
+            sampledReferences[i]++;
+            sampledWeight[i] += referenceWeight[i];
+            long long distance = trackers[i].Access(page);
+            if (distance != 0) {
+                distanceCounts[i][min<long long>(1 + llround((distance - 1) / rate), totalFrames + 1)] += referenceWeight[i];
                 continue;
             }
+            if (!samplePageCaps[i]) continue;
+
+            // Over the cap: drop every page at the largest hash and lower the threshold to it
+            sampledPages[i].push_back({hash, page});
+            push_heap(sampledPages[i].begin(), sampledPages[i].end());
+            if (trackers[i].activePages <= samplePageCaps[i]) continue;
+            uint64_t lowered = sampledPages[i].front().first;
+            while (!sampledPages[i].empty() && sampledPages[i].front().first == lowered) {
+                trackers[i].Remove(sampledPages[i].front().second);
+                pop_heap(sampledPages[i].begin(), sampledPages[i].end());
+                sampledPages[i].pop_back();
+            }
+            referenceWeight[i] *= double(sampleThresholds[i][1] - sampleThresholds[i][0]) / (lowered - sampleThresholds[i][0]);
+            sampleThresholds[i][1] = lowered;
+        }
+    }
+
+    // Miss ratios per frame count; a sample holding more or fewer references than its rate
+    // predicts is corrected at the shortest distance (SHARDS_adj)
+    vector<double> ratios[3];
+    for (int i = 0; i < 3; i++) {
+        if (referenceWeight[i] != 1) {
+            for (double &count : distanceCounts[i]) {
+                count /= referenceWeight[i];
+            }
+            sampledWeight[i] /= referenceWeight[i];
+        }
+        double expected = simulatedReferences * double(sampleThresholds[i][1] - sampleThresholds[i][0]) / HASH_RANGE;
+        distanceCounts[i][1] += expected - sampledWeight[i];
+        double misses = expected;
+        ratios[i].assign(totalFrames + 1, 0);
+        for (size_t frames = 1; frames <= totalFrames; frames++) {
+            misses -= distanceCounts[i][frames];
+            ratios[i][frames] = expected > 0 ? min(1.0, max(0.0, misses / expected)) : 0.0;
+        }
+    }
+
+    cout << "Pages referenced: " << totalPageReferences << '\n'
+         << "Sampling rate: " << double(sampleThresholds[0][1]) / HASH_RANGE << '\n'
+         << "Sampled references: " << sampledReferences[0] << '\n'
+         << "Sampled pages: " << trackers[0].activePages << '\n';
+
+    cout << "Approximate miss ratio curve" << '\n';
+    double errorSum = 0, errorMax = 0;
+    for (size_t frames = 1; frames <= totalFrames; frames++) {
+        cout << setw(5) << frames << " misses:" << llround(ratios[0][frames] * simulatedReferences)
+             << " ratio:" << fixed << setprecision(4) << ratios[0][frames] << '\n';
+        double error = sampleThresholds[0][1] < HASH_RANGE ? fabs(ratios[1][frames] - ratios[2][frames]) / 2 : 0.0;
+        errorSum += error;
+        errorMax = max(errorMax, error);
+    }
+    cout << "Estimated ratio error (half-sample disagreement): mean " << fixed << setprecision(4)
+         << errorSum / totalFrames << " max " << errorMax << endl;
+}
+
+// Function to parse the whole trace once into the buffer the ALL threads share
+void BufferTraceRecords() {
+    size_t offset = traceBodyOffset;
+    long long previousAddress = 0;
+    TraceRecord record;
+    for (size_t lineIndex = 0; NextTraceRecord(offset, previousAddress, record); lineIndex++) {
+        if (record.kind == RECORD_SKIP) continue;
+
+        // Report invalid lines here, once, instead of from every thread
+        if (record.kind > RECORD_REFERENCE && !binaryTrace) {
+            ReportInvalidRecord(record, lineIndex);
+        }
+
+        sharedRecords.push_back({record.memLocation, record.operation, record.kind, record.cpu});
+    }
+}
+
+// Function to run every policy in ALL_ALGORITHMS concurrently over one parse of the trace
+void RunAllAlgorithms() {
+    const int algorithmCount = sizeof(ALL_ALGORITHMS) / sizeof(ALL_ALGORITHMS[0]);
+
+    BufferTraceRecords();
+    vector<int> nextUseTable;
+    AnalyzeFuturePageReferences(nextUseTable, true);
+
+    ostringstream outputs[algorithmCount];
+    vector<thread> threads;
+    for (int i = 0; i < algorithmCount; i++) {
+        SimulationConfig config = {ALL_ALGORITHMS[i], pageSize, totalFrames, totalPages, nextUseTable.data()};
+        threads.emplace_back(RunSimulation, config, debugMode, &outputs[i]);
+    }
+
+    // Print each policy's block in a fixed order, exactly as a separate run would
+    for (int i = 0; i < algorithmCount; i++) {
+        threads[i].join();
+        cout << outputs[i].str();
+    }
+    cout.flush();
+}
+
+// Function to run every (policy, page size, frame count) combination over one parse of the trace
+void RunParameterSweep() {
+    vector<const char *> algorithms;
+    if (replacementPolicy == POLICY_ALL) {
+        algorithms.assign(begin(ALL_ALGORITHMS), end(ALL_ALGORITHMS));
+    } else {
+        algorithms.push_back(replacementAlgorithm);
+    }
+
+    // Unswept dimensions keep the value from the trace
+    if (sweepFrameCounts.empty()) sweepFrameCounts.push_back(totalFrames);
+    if (sweepPageSizes.empty()) sweepPageSizes.push_back(pageSize);
+    if (*max_element(sweepFrameCounts.begin(), sweepFrameCounts.end()) > MAX_FRAMES) {
+        cerr << "Error: Number of frames exceeds the maximum of " << MAX_FRAMES << "." << endl;
+        exit(1);
+    }
+
+    BufferTraceRecords();
+
+    // Page counts scale so every page size covers the address space the trace configured,
+    // and OPTIMAL (or -f) needs its own lookahead per page size
+    const size_t baseAddressSpace = pageSize * totalPages;
+    const size_t basePageSize = pageSize, basePages = totalPages;
+    vector<size_t> pagesForSize(sweepPageSizes.size());
+    vector<vector<int>> nextUseTables(sweepPageSizes.size());
+    bool needsLookahead = find_if(algorithms.begin(), algorithms.end(),
+                                  [](const char *name) { return !strcmp(name, "OPTIMAL"); }) != algorithms.end() ||
+                          releaseRetiredPages;
+    for (size_t i = 0; i < sweepPageSizes.size(); i++) {
+        pagesForSize[i] = max<size_t>(1, (baseAddressSpace + sweepPageSizes[i] - 1) / sweepPageSizes[i]);
+        if (needsLookahead) {
+            pageSize = sweepPageSizes[i];
+            totalPages = pagesForSize[i];
+            AnalyzeFuturePageReferences(nextUseTables[i], true);
+        }
+    }
+    pageSize = basePageSize;
+    totalPages = basePages;
+
+    vector<SimulationConfig> configs;
+    for (const char *algorithm : algorithms) {
+        for (size_t i = 0; i < sweepPageSizes.size(); i++) {
+            for (size_t frames : sweepFrameCounts) {
+                configs.push_back({algorithm, sweepPageSizes[i], frames, pagesForSize[i], nextUseTables[i].data()});
+            }
+        }
+    }
+
+    // Workers pull configurations off a shared counter until none are left
+    vector<SimulationCounters> results(configs.size());
+    atomic<size_t> nextConfig(0);
+    auto worker = [&]() {
+        for (size_t i = nextConfig++; i < configs.size(); i = nextConfig++) {
+            results[i] = RunSimulation(configs[i], 0, nullptr);
+        }
+    };
+    size_t workerCount = min<size_t>(max(1u, thread::hardware_concurrency()), configs.size());
+    vector<thread> workers;
+    for (size_t i = 0; i < workerCount; i++) {
+        workers.emplace_back(worker);
+    }
+    for (thread &t : workers) {
+        t.join();
+    }
+
+    cout << "algorithm,page_size,frames,pages,references,mapped,misses,stolen,written,recovered" << '\n';
+    for (size_t i = 0; i < configs.size(); i++) {
+        const SimulationConfig &config = configs[i];
+        const SimulationCounters &counters = results[i];
+        cout << config.algorithm << ',' << config.pageSize << ',' << config.frames << ',' << config.pages << ','
+             << counters.references << ',' << counters.mapped << ',' << counters.misses << ','
+             << counters.stolen << ',' << counters.written << ',' << counters.recovered << '\n';
+    }
+
+    // Flag Belady anomalies: more frames, more misses, for the same policy and page size
+    for (size_t i = 0; i < configs.size(); i++) {
+        for (size_t j = 0; j < configs.size(); j++) {
+            if (configs[i].algorithm == configs[j].algorithm && configs[i].pageSize == configs[j].pageSize &&
+                configs[j].frames > configs[i].frames && results[j].misses > results[i].misses) {
+                cout << "# Belady anomaly: " << configs[i].algorithm << " page_size=" << configs[i].pageSize
+                     << " frames " << configs[i].frames << "->" << configs[j].frames
+                     << " misses " << results[i].misses << "->" << results[j].misses << '\n';
+            }
+        }
+    }
+    cout.flush();
+}
+
+// Function to simulate one configuration over the shared records with private tables.
+// A null output runs silently (sweeps only want the counters).
+SimulationCounters RunSimulation(const SimulationConfig &config, int startDebugMode, ostream *output) {
+    Page *pageTable;
+    Frame *frameTable;
+    BeginSimulation(config, startDebugMode, output, pageTable, frameTable);
+
+    for (size_t recordIndex = 0; recordIndex < sharedRecords.size(); recordIndex++) {
+        const BufferedRecord &record = sharedRecords[recordIndex];
+        long long currentPage = record.kind == RECORD_REFERENCE ? PageNumberFor(record.memLocation) : -1;
+        SimulateRecord(record.kind, record.operation, currentPage, record.cpu, recordIndex, pageTable, frameTable);
+    }
+
+    FinishIntervals();
+    DisplayResults(pageTable, frameTable, true);
+    if (startDebugMode && output) {
+        *output << "Heap allocations while simulating references: " << referenceHeapAllocations << '\n';
+    }
+
+    SimulationCounters counters = {totalPageReferences, totalPagesMapped, totalPageMisses,
+                                   totalFramesStolen, totalFramesWrittenToDisk, totalFramesRecoveredFromDisk};
+    ReleaseResources(pageTable, frameTable);
+    return counters;
+}
+
+// Function to map an algorithm name to its policy, so references never compare names
+ReplacementPolicy ResolveReplacementPolicy(const char *algorithm) {
+    for (size_t i = 0; i < size(ALL_ALGORITHMS); i++) {
+        if (strcmp(algorithm, ALL_ALGORITHMS[i]) == 0) {
+            return static_cast<ReplacementPolicy>(i);
+        }
+    }
+    return POLICY_ALL;
+}
+
+// Function to point this thread's simulation state at a configuration and allocate its tables
+void BeginSimulation(const SimulationConfig &config, int startDebugMode, ostream *output, Page *&pageTable, Frame *&frameTable) {
+    ResetSimulationState();
+    replacementAlgorithm = config.algorithm;
+    replacementPolicy = ResolveReplacementPolicy(config.algorithm);
+    pageSize = config.pageSize;
+    totalFrames = config.frames;
+    totalPages = config.pages;
+    nextUseLine = config.nextUse;
+    debugMode = startDebugMode;
+    reportOutput = output;
+
+    InitializeBackingStore();
+    pageTable = wideAddresses ? nullptr : new Page[totalPages];
+    frameTable = new Frame[totalFrames];
+    InitializeReplacementState();
+    InitializeIntervals();
+
+    DisplayInitialConfiguration();
+}
+
+// Function to time every policy on every generator and table size. Each case runs in a forked
+// child so its peak RSS is its own; children run one at a time and print their own row.
+void RunBenchmark() {
+    vector<const char *> algorithms;
+    if (replacementPolicy == POLICY_ALL) {
+        algorithms.assign(begin(ALL_ALGORITHMS), end(ALL_ALGORITHMS));
+    } else {
+        algorithms.push_back(replacementAlgorithm);
+    }
+    if (benchScaling) {
+        benchPageCounts.assign(begin(SCALING_PAGES), end(SCALING_PAGES));
+    } else if (benchPageCounts.empty()) {
+        benchPageCounts = {65536, 1048576};
+    }
+    if (find(benchGenerators.begin(), benchGenerators.end(), true) == benchGenerators.end()) {
+        benchGenerators.assign(GENERATOR_COUNT, true);
+    }
+
+    // Each case reports its time through shared memory, for the scaling comparison
+    vector<double> caseNanoseconds;
+    vector<string> caseNames;
+    benchCaseNanoseconds = static_cast<double *>(mmap(nullptr, sizeof(double), PROT_READ | PROT_WRITE,
+                                                      MAP_SHARED | MAP_ANONYMOUS, -1, 0));
+    if (benchCaseNanoseconds == MAP_FAILED) {
+        cerr << "Error: Unable to map benchmark results." << endl;
+        exit(1);
+    }
+
+    cout << "algorithm,generator,pages,frames,references,misses,refs_per_sec,ns_per_ref,peak_rss_kb" << endl;
+    for (size_t pages : benchPageCounts) {
+        vector<size_t> frameCounts = sweepFrameCounts;
+        if (benchScaling) {
+            frameCounts.assign(1, SCALING_FRAMES[pages == SCALING_PAGES[1]]);
+        } else if (frameCounts.empty()) {
+            frameCounts.push_back(max<size_t>(1, pages / 8));
+        }
+        for (size_t frames : frameCounts) {
+            if (frames > MAX_FRAMES) {
+                cerr << "Error: Number of frames exceeds the maximum of " << MAX_FRAMES << "." << endl;
+                exit(1);
+            }
+            for (int kind = 0; kind < GENERATOR_COUNT; kind++) {
+                if (!benchGenerators[kind]) continue;
+
+                // Set up the generator once (the Zipfian constants cost a pass over the pages)
+                TraceGenerator prototype;
+                InitializeGenerator(prototype, static_cast<GeneratorKind>(kind), pages, frames);
+                for (const char *algorithm : algorithms) {
+                    pid_t child = fork();
+                    if (child == -1) {
+                        cerr << "Error: Unable to fork benchmark case." << endl;
+                        exit(1);
+                    }
+                    if (child == 0) {
+                        RunBenchmarkCase(algorithm, prototype, frames);
+                        cout.flush();
+                        _exit(0);
+                    }
+                    int status;
+                    waitpid(child, &status, 0);
+                    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+                        cerr << "Error: Benchmark case " << algorithm << " " << GENERATOR_NAMES[kind] << " failed." << endl;
+                        exit(1);
+                    }
+                    caseNanoseconds.push_back(*benchCaseNanoseconds);
+                    caseNames.push_back(string(algorithm) + " " + GENERATOR_NAMES[kind]);
+                }
+            }
+        }
+    }
+    munmap(benchCaseNanoseconds, sizeof(double));
+
+    // Cases ran small table first, so case i on the large table is case i + half
+    if (benchScaling) {
+        size_t half = caseNanoseconds.size() / 2;
+        bool passed = true;
+        for (size_t i = 0; i < half; i++) {
+            double slowdown = caseNanoseconds[i + half] / caseNanoseconds[i];
+            cout << "Scaling " << caseNames[i] << ": " << fixed << setprecision(2) << slowdown << "x" << endl;
+            if (slowdown > SCALING_MAX_SLOWDOWN) {
+                cerr << "Error: " << caseNames[i] << " is " << slowdown << " times slower per reference on "
+                     << SCALING_PAGES[1] << " pages and " << SCALING_FRAMES[1] << " frames." << endl;
+                passed = false;
+            }
+        }
+        if (!passed) {
+            exit(1);
+        }
+    }
+}
+
+// Function to run one benchmark case, streaming generated references straight into the simulator
+void RunBenchmarkCase(const char *algorithm, const TraceGenerator &prototype, size_t frames) {
+    const size_t benchPageSize = 4096;
+    totalBackingStoreBlocks = prototype.pages;
+    TraceGenerator generator;
+    char operation;
+    unsigned long long memLocation;
+
+    // OPTIMAL (and -f) need the next use of every reference: replay the stream once ahead
+    vector<int> nextUseTable;
+    if (strcmp(algorithm, "OPTIMAL") == 0 || releaseRetiredPages) {
+        vector<int> previousUse(prototype.pages, -1);
+        nextUseTable.assign(benchReferences, INT_MAX);
+        generator = prototype;
+        for (long long i = 0; i < benchReferences; i++) {
+            NextGeneratedReference(generator, operation, memLocation);
+            int &lastUse = previousUse[memLocation / benchPageSize];
+            if (lastUse != -1) {
+                nextUseTable[lastUse] = i;
+            }
+            lastUse = i;
+        }
+    }
+
+    SimulationConfig config = {algorithm, benchPageSize, frames, prototype.pages, nextUseTable.data()};
+    Page *pageTable;
+    Frame *frameTable;
+    BeginSimulation(config, 0, nullptr, pageTable, frameTable);
+
+    generator = prototype;
+    auto start = chrono::steady_clock::now();
+    for (long long i = 0; i < benchReferences; i++) {
+        NextGeneratedReference(generator, operation, memLocation);
+        SimulateRecord(RECORD_REFERENCE, operation, PageNumberFor(memLocation), 0, i, pageTable, frameTable);
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    FinishIntervals();
+    *benchCaseNanoseconds = seconds * 1e9 / benchReferences;
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    cout << algorithm << ',' << GENERATOR_NAMES[prototype.kind] << ',' << prototype.pages << ',' << frames << ','
+         << benchReferences << ',' << totalPageMisses << ','
+         << fixed << setprecision(0) << benchReferences / seconds << ','
+         << setprecision(1) << seconds * 1e9 / benchReferences << ',' << usage.ru_maxrss << '\n';
+    ReleaseResources(pageTable, frameTable);
+}
+
+// Function to seed a generator and precompute its pattern constants
+void InitializeGenerator(TraceGenerator &generator, GeneratorKind kind, size_t pages, size_t frames) {
+    generator.kind = kind;
+    generator.state = benchSeed * 0x9E3779B97F4A7C15ULL + kind;
+    generator.pages = pages;
+    generator.loopPages = min(pages, max<size_t>(1, frames + frames / 4));
+    generator.position = 0;
+    generator.generated = 0;
+    generator.phaseLength = max(1LL, benchReferences / 8);
+
+    const double theta = 0.99;
+    double zetaN = 0;
+    if (kind == GENERATOR_ZIPF || kind == GENERATOR_PHASED) {
+        for (size_t i = 1; i <= pages; i++) {
+            zetaN += 1.0 / pow((double)i, theta);
+        }
+    }
+    double zeta2 = 1.0 + pow(0.5, theta);
+    generator.zipfZetaN = zetaN;
+    generator.zipfAlpha = 1.0 / (1.0 - theta);
+    generator.zipfEta = (1.0 - pow(2.0 / pages, 1.0 - theta)) / (1.0 - zeta2 / zetaN);
+    generator.zipfHalfPow = pow(0.5, theta);
+}
+
+// Function to produce the next reference of a generator: 30% writes, random offset in the page
+void NextGeneratedReference(TraceGenerator &generator, char &operation, unsigned long long &memLocation) {
+    auto nextRandom = [&generator]() {
+        uint64_t z = (generator.state += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    };
+    auto nextZipf = [&]() -> size_t {
+        double u = (nextRandom() >> 11) * 0x1.0p-53;
+        double uz = u * generator.zipfZetaN;
+        if (uz < 1.0) return 0;
+        if (uz < 1.0 + generator.zipfHalfPow) return 1;
+        size_t rank = generator.pages * pow(generator.zipfEta * u - generator.zipfEta + 1.0, generator.zipfAlpha);
+        return min(rank, generator.pages - 1);
+    };
+
+    size_t page;
+    switch (generator.kind) {
+    case GENERATOR_UNIFORM:
+        page = nextRandom() % generator.pages;
+        break;
+    case GENERATOR_ZIPF:
+        page = nextZipf();
+        break;
+    case GENERATOR_SEQUENTIAL:
+        page = generator.position++ % generator.pages;
+        break;
+    case GENERATOR_LOOP:
+        page = generator.position++ % generator.loopPages;
+        break;
+    default: {
+        // Even phases: Zipfian around a hot set that moves by an eighth of the pages; odd phases: a scan
+        long long phase = generator.generated / generator.phaseLength;
+        if (phase % 2 == 0) {
+            page = (nextZipf() + phase / 2 * (generator.pages / 8)) % generator.pages;
+        } else {
+            page = generator.position++ % generator.pages;
+        }
+        break;
+    }
+    }
+    generator.generated++;
+
+    operation = nextRandom() % 10 < 3 ? 'w' : 'r';
+    memLocation = (unsigned long long)page * 4096 + nextRandom() % 4096;
+}
+
+// Function to put this thread's simulation state back to its starting values
+void ResetSimulationState() {
+    totalPageReferences = totalPagesMapped = totalPageMisses = 0;
+    totalFramesStolen = totalFramesWrittenToDisk = totalFramesRecoveredFromDisk = 0;
+    isInitialConfigPrinted = false;
+    backingStoreTable = nullptr;
+    backingStoreBlocksInUse = backingStoreBlocksRead = backingStoreBlocksWritten = 0;
+    backingStoreBlocksReleased = backingStoreBlocksReused = backingStoreBlocksPeak = 0;
+    retiredPageWritesAvoided = 0;
+    freeBlockBitmap.clear();
+    pageBackingStoreBlock.clear();
+    sparsePageBackingStoreBlock.clear();
+    radixRoot = nullptr;
+    radixHeight = 0;
+    radixNodesAllocated = 0;
+    cachedLeaf = nullptr;
+    cachedLeafBase = -1;
+    referenceHeapAllocations = 0;
+    nextUnusedFrame = 0;
+    leastRecentFrame = mostRecentFrame = -1;
+    optimalHeap.clear();
+    optimalHeapPosition.clear();
+    frameNextUse.clear();
+    clockHand = 0;
+    clockHandAdvances = clockHandRevolutions = 0;
+    clockReferenceBitsCleared = clockDirtyFramesSkipped = 0;
+    clockCleanVictims = clockDirtyVictims = 0;
+    intervalBufferUsed = 0;
+    intervalIndex = intervalDistinctPages = 0;
+    pageLastInterval.clear();
+    sparsePageLastInterval.clear();
+    freeFrames.clear();
+    workingSetTrims = workingSetFramesSkipped = workingSetCleaningWrites = 0;
+    workingSetRing.clear();
+    pageLastReference.clear();
+    sparsePageLastReference.clear();
+    workingSetTime = 0;
+    workingSetSize = workingSetPeak = 0;
+    workingSetSizeSum = workingSetSamples = 0;
+    policyNodes.clear();
+    freePolicyNodes.clear();
+    for (PolicyList &list : policyLists) {
+        list = PolicyList();
+    }
+    policyNodeOfPage.clear();
+    sparsePolicyNodeOfPage.clear();
+    arcTargetT1 = twoQueueKin = twoQueueKout = lirsLirLimit = lirsLirCount = 0;
+    pinnedPolicyNode = -1;
+    prefetchActive = false;
+    prefetchesIssued = prefetchesUsed = prefetchesEvictedUnused = 0;
+    prefetchPollutionMisses = prefetchSwapReads = 0;
+    strideLastMiss = historyLastMiss = -1;
+    strideLastDelta = 0;
+    prefetchHistory.clear();
+    pollutedPageBits.clear();
+    framesInUse = 0;
+    pageOutActive = false;
+    pageOutWakeups = pageOutReclaims = pageOutReclaimWrites = 0;
+    pageOutCleanings = pageOutExtraWrites = 0;
+    pageOutCandidates.clear();
+    hugePagesActive = false;
+    regionState.clear();
+    sparseRegionState.clear();
+    hugePromotions = hugePromotionsDeferred = hugeDemotions = hugePagesMapped = 0;
+    hugePageReferences = 0;
+    hugeFillFrames = hugeFillSwapReads = hugeFillsEvictedUntouched = 0;
+    hugeUntouchedFrames = hugeUntouchedPeak = 0;
+    numaActive = numaNodeLocal = false;
+    accessNode = numaTargetNode = 0;
+    victimNode = -1;
+    nodeFreeFrames.clear();
+    nodeNextUnusedFrame.clear();
+    numaCounters.clear();
+}
+
+// Function to parse a sweep list such as "4..4096:x2", "512,4096" or "1..8:+1", of at most
+// MAX_SWEEP_VALUES entries
+bool ParseSweepList(const char *spec, vector<size_t> &values) {
+    string_view rest(spec);
+    while (!rest.empty()) {
+        size_t comma = rest.find(',');
+        string_view item = rest.substr(0, comma);
+        rest = comma == string_view::npos ? string_view() : rest.substr(comma + 1);
+
+        size_t first, last, step = 1;
+        bool multiply = false;
+        char *end;
+        string itemText(item);
+        errno = 0;
+        first = strtoull(itemText.c_str(), &end, 10);
+        last = first;
+        if (strncmp(end, "..", 2) == 0) {
+            last = strtoull(end + 2, &end, 10);
+            if (*end == ':') {
+                end++;
+                multiply = *end == 'x';
+                if (*end == 'x' || *end == '+') end++;
+                step = strtoull(end, &end, 10);
+            }
+        }
+        if (*end != '\0' || errno == ERANGE || first == 0 || last < first || step == 0 || (multiply && step < 2)) {
+            return false;
+        }
+
+        // Stop before the next value would pass last, which also keeps it from overflowing
+        for (size_t value = first;; value = multiply ? value * step : value + step) {
+            if (values.size() == MAX_SWEEP_VALUES) {
+                return false;
+            }
+            values.push_back(value);
+            if (multiply ? value > last / step : last - value < step) break;
+        }
+    }
+    return !values.empty();
+}
+
+void InitializeBackingStore() {
+    if (backingStoreEnabled && !wideAddresses) {
+        pageBackingStoreBlock.assign(totalPages, -1);
+    }
+
+    // Initialize backing store if enabled
+    if (backingStoreEnabled && totalBackingStoreBlocks > 0) {
+        backingStoreTable = new BackingStoreBlock[totalBackingStoreBlocks];
+
+        // Every block starts free; bits past the last block stay clear
+        size_t blocks = totalBackingStoreBlocks;
+        do {
+            vector<uint64_t> level((blocks + 63) / 64, ~0ULL);
+            if (blocks % 64) {
+                level.back() = (1ULL << (blocks % 64)) - 1;
+            }
+            freeBlockBitmap.push_back(move(level));
+            blocks = freeBlockBitmap.back().size();
+        } while (blocks > 1);
+    }
+}
+
+// Function to create the swap file at full size and start its I/O threads
+void OpenSwapFile() {
+    swapBlockSize = (pageSize + 4095) / 4096 * 4096;
+    swapDirect = true;
+    swapFd = open(swapFilename, O_RDWR | O_CREAT | O_DIRECT, 0644);
+    if (swapFd == -1 && errno == EINVAL) {
+        // tmpfs and some network file systems have no O_DIRECT; synchronous writes still reach the device
+        swapDirect = false;
+        swapFd = open(swapFilename, O_RDWR | O_CREAT | O_DSYNC, 0644);
+        cerr << "Warning: " << swapFilename << " does not support O_DIRECT, using O_DSYNC" << endl;
+    }
+    if (swapFd == -1) {
+        cerr << "Error: Cannot open swap file " << swapFilename << endl;
+        exit(1);
+    }
+
+    // Allocate every block up front so reads hit the device rather than a hole
+    off_t size = (off_t)totalBackingStoreBlocks * swapBlockSize;
+    if (posix_fallocate(swapFd, 0, size) != 0 && ftruncate(swapFd, size) != 0) {
+        cerr << "Error: Cannot size swap file " << swapFilename << endl;
+        exit(1);
+    }
+
+    swapWorkers = new SwapWorker[swapThreads];
+    for (int i = 0; i < swapThreads; i++) {
+        if (posix_memalign(&swapWorkers[i].buffer, 4096, swapBlockSize) != 0) {
+            cerr << "Error: Cannot allocate swap I/O buffer" << endl;
+            exit(1);
+        }
+        memset(swapWorkers[i].buffer, 0, swapBlockSize);
+        swapWorkers[i].worker = thread(RunSwapWorker, &swapWorkers[i]);
+    }
+}
+
+// Function to queue one block of swap I/O, waiting while its thread's queue is full
+void SubmitSwapIo(bool isWrite, int block, long long pageNumber) {
+    SwapWorker &worker = swapWorkers[block % swapThreads];
+    unique_lock<mutex> guard(worker.lock);
+    worker.changed.wait(guard, [&worker]() { return worker.queue.size() < SWAP_QUEUE_DEPTH; });
+    worker.queue.push_back({isWrite, block, pageNumber, chrono::steady_clock::now()});
+    worker.changed.notify_all();
+}
+
+// Function run by each swap I/O thread until it is stopped and its queue is empty
+void RunSwapWorker(SwapWorker *worker) {
+    while (true) {
+        SwapRequest request;
+        {
+            unique_lock<mutex> guard(worker->lock);
+            worker->changed.wait(guard, [worker]() { return worker->stopping || !worker->queue.empty(); });
+            if (worker->queue.empty()) return;
+            request = worker->queue.front();
+            worker->queue.pop_front();
+        }
+        worker->changed.notify_all();
+
+        off_t offset = (off_t)request.block * swapBlockSize;
+        ssize_t transferred;
+        if (request.isWrite) {
+            memcpy(worker->buffer, &request.pageNumber, sizeof(request.pageNumber));
+            transferred = pwrite(swapFd, worker->buffer, swapBlockSize, offset);
+        } else {
+            transferred = pread(swapFd, worker->buffer, swapBlockSize, offset);
+            long long stamp;
+            memcpy(&stamp, worker->buffer, sizeof(stamp));
+            if (transferred == (ssize_t)swapBlockSize && stamp != request.pageNumber) {
+                worker->verifyFailures++;
+            }
+        }
+        if (transferred != (ssize_t)swapBlockSize) {
+            cerr << "Error: Swap file " << (request.isWrite ? "write" : "read") << " failed at block " << request.block << endl;
+            exit(1);
+        }
+
+        double microseconds = chrono::duration<double, micro>(chrono::steady_clock::now() - request.submitted).count();
+        SwapLatency &latency = worker->latency[request.isWrite];
+        latency.count++;
+        latency.totalMicroseconds += microseconds;
+        latency.buckets[microseconds < 1 ? 0 : min(SWAP_LATENCY_BUCKETS - 1, 1 + (int)log2(microseconds))]++;
+    }
+}
+
+// Function to let the I/O threads drain their queues, then merge their statistics and close the file
+void CloseSwapFile() {
+    for (int i = 0; i < swapThreads; i++) {
+        SwapWorker &worker = swapWorkers[i];
+        {
+            lock_guard<mutex> guard(worker.lock);
+            worker.stopping = true;
+        }
+        worker.changed.notify_all();
+        worker.worker.join();
+
+        for (int op = 0; op < 2; op++) {
+            swapLatency[op].count += worker.latency[op].count;
+            swapLatency[op].totalMicroseconds += worker.latency[op].totalMicroseconds;
+            for (int b = 0; b < SWAP_LATENCY_BUCKETS; b++) {
+                swapLatency[op].buckets[b] += worker.latency[op].buckets[b];
+            }
+        }
+        swapVerifyFailures += worker.verifyFailures;
+        free(worker.buffer);
+    }
+    delete[] swapWorkers;
+    swapWorkers = nullptr;
+    close(swapFd);
+    swapFd = -1;
+}
+
+// Function to print the swap file's latency summary and histograms
+void DisplaySwapStatistics(ostream &out) {
+    out << "Swap file: " << swapFilename << " (" << (swapDirect ? "O_DIRECT" : "O_DSYNC") << ", "
+        << swapBlockSize << "-byte blocks, " << swapThreads << " I/O threads)" << '\n';
+
+    static const char *const OPERATION_NAMES[] = {"Swap-in", "Swap-out"};
+    for (int op = 0; op < 2; op++) {
+        const SwapLatency &latency = swapLatency[op];
+
+        // Percentiles resolve to the upper bound of the bucket they fall in
+        auto percentile = [&latency](double fraction) {
+            long long seen = 0;
+            for (int b = 0; b < SWAP_LATENCY_BUCKETS; b++) {
+                seen += latency.buckets[b];
+                if (seen > 0 && seen >= fraction * latency.count) return 1LL << b;
+            }
+            return 0LL;
+        };
+        out << OPERATION_NAMES[op] << ": " << latency.count << " blocks, mean "
+            << (latency.count ? latency.totalMicroseconds / latency.count : 0.0) << " us, p50 <" << percentile(0.5)
+            << " us, p99 <" << percentile(0.99) << " us" << '\n';
+        for (int b = 0; b < SWAP_LATENCY_BUCKETS; b++) {
+            if (latency.buckets[b] != 0) {
+                out << setw(12) << (b == 0 ? 0 : 1LL << (b - 1)) << "-" << (1LL << b) << " us: " << latency.buckets[b] << '\n';
+            }
+        }
+    }
+    out << "Swap-in blocks failing verification: " << swapVerifyFailures << '\n';
+}
+
+void AnalyzeFuturePageReferences(vector<int> &nextUse, bool fromSharedRecords) {
+    // Preprocess future page references for OPTIMAL algorithm
+    // Make a separate pass over the trace (or the shared buffer) so each reference learns the
+    // next line touching its page (keyed sparsely when 64-bit page numbers cannot index a vector)
+    vector<int> previousUse(wideAddresses ? 0 : totalPages, -1);
+    unordered_map<long long, int> previousSparseUse;
+    size_t offset = traceBodyOffset;
+    long long previousAddress = 0;
+    TraceRecord record;
+    for (size_t lineIndex = 0;; lineIndex++) {
+        if (fromSharedRecords) {
+            if (lineIndex == sharedRecords.size()) break;
+            record.kind = sharedRecords[lineIndex].kind;
+            record.memLocation = sharedRecords[lineIndex].memLocation;
+        } else if (!NextTraceRecord(offset, previousAddress, record)) {
+            break;
+        }
+        nextUse.push_back(INT_MAX);
+
+        // Skip comments, commands and invalid lines
+        if (record.kind != RECORD_REFERENCE) continue;
+
+        long long pageNum = PageNumberFor(record.memLocation);
+        int &lastUse = wideAddresses ? previousSparseUse.emplace(pageNum, -1).first->second : previousUse[pageNum];
+        if (lastUse != -1) {
+            nextUse[lastUse] = lineIndex;
+        }
+        lastUse = lineIndex;
+    }
+}
+
+// Function to set up the replacement policy's own bookkeeping for this simulation
+void InitializeReplacementState() {
+    if (replacementPolicy == POLICY_OPTIMAL) {
+        optimalHeap.reserve(totalFrames);
+        optimalHeapPosition.assign(totalFrames, -1);
+        frameNextUse.assign(totalFrames, INT_MAX);
+    }
+
+    if (IsWorkingSetAlgorithm()) {
+        freeFrames.reserve(totalFrames);
+        workingSetRing.assign(workingSetWindow, -1);
+        if (wideAddresses) {
+            sparsePageLastReference.reserve(totalFrames);
+        } else {
+            pageLastReference.assign(totalPages, INT_MIN / 2);
+        }
+    }
+
+    if (IsAdaptiveAlgorithm()) {
+        // Ghosts are bounded by the frame count, so the arena never grows while simulating
+        policyNodes.reserve(2 * totalFrames + 1);
+        freePolicyNodes.reserve(2 * totalFrames + 1);
+        if (wideAddresses) {
+            sparsePolicyNodeOfPage.reserve(2 * totalFrames + 1);
+        } else {
+            policyNodeOfPage.assign(totalPages, -1);
+        }
+        arcTargetT1 = 0;
+        twoQueueKin = max<size_t>(1, totalFrames / 4);
+        twoQueueKout = max<size_t>(1, totalFrames / 2);
+        lirsLirLimit = totalFrames - max<size_t>(1, totalFrames / 100);
+    }
+
+    // OPTIMAL keys frames by their page's next reference, which a prefetched page does not have
+    prefetchActive = prefetchPolicy != PREFETCH_NONE && replacementPolicy != POLICY_OPTIMAL;
+    if (prefetchActive && prefetchPolicy == PREFETCH_HISTORY) {
+        prefetchHistory.assign(PREFETCH_HISTORY_ENTRIES, PrefetchHistoryEntry());
+    }
+    if (prefetchActive && !wideAddresses) {
+        pollutedPageBits.assign((totalPages + 63) / 64, 0);
+    }
+
+    // The daemon needs room between its watermarks and a full memory
+    pageOutActive = lowWatermark > 0 && highWatermark < totalFrames && SupportsPageOutDaemon();
+    if (pageOutActive) {
+        pageOutCandidates.reserve(totalFrames);
+    }
+
+    // Promotion fills have no next use for OPTIMAL to order them by
+    hugePagesActive = hugePageShift > 0 && replacementPolicy != POLICY_OPTIMAL;
+    if (hugePagesActive && !wideAddresses) {
+        regionState.assign(((totalPages - 1) >> hugePageShift) + 1, 0);
+    }
+
+    // Picking a victim for ARC, 2Q or LIRS moves pages between their lists, so they replace globally
+    numaActive = numaNodes > 0;
+    if (numaActive) {
+        if (totalFrames < (size_t)numaNodes) {
+            cerr << "Error: --numa needs at least one frame per node." << endl;
+            exit(1);
+        }
+        numaNodeLocal = numaLocalReplacement && !IsAdaptiveAlgorithm();
+        nodeFreeFrames.assign(numaNodes, vector<int>());
+        nodeNextUnusedFrame.resize(numaNodes);
+        for (int node = 0; node < numaNodes; node++) {
+            nodeFreeFrames[node].reserve(NodeFirstFrame(node + 1) - NodeFirstFrame(node));
+            nodeNextUnusedFrame[node] = NodeFirstFrame(node);
+        }
+        numaCounters.assign(numaNodes, NumaNodeCounters());
+    }
+}
+
+void DisplayInitialConfiguration() {
+    // Print initial configuration
+    if (reportOutput != nullptr && !isInitialConfigPrinted && debugMode == 0) {
+        isInitialConfigPrinted = true;
+        ostream &out = *reportOutput;
+
+        // Output remains unchanged
+        out << "Page size: " << pageSize << endl;
+        out << "Num frames: " << totalFrames << endl;
+        if (wideAddresses) {
+            out << "Num pages: sparse (64-bit addresses)" << endl;
+        } else {
+            out << "Num pages: " << totalPages << endl;
+        }
+        out << "Num backing blocks: " << totalBackingStoreBlocks << endl;
+        out << "Reclaim algorithm: " << replacementAlgorithm << endl;
+        if (IsWorkingSetAlgorithm()) {
+            out << "Working-set window (tau): " << workingSetWindow << endl;
+        }
+    }
+}
+
+void ParseCommandLineArguments(int argc, char *argv[]) {
+    if (argc < 3) {  // Need at least program name + algo + filename
+        ShowUsage();
+    }
+
+    bool algorithmSpecified = false;
+
+    for (int i = 1; i < argc; i++) {
+        char* arg = argv[i];
+
+        // Miss ratio curve mode: --mrc filename (always LRU)
+        if (!strcmp(arg, "--mrc")) {
+            missRatioCurveMode = true;
+            continue;
+        }
+
+        // Sampled miss ratio curve: --sample R, 0 < R <= 1 (implies --mrc)
+        if (!strcmp(arg, "--sample")) {
+            char *end = nullptr;
+            double rate = i + 1 < argc ? strtod(argv[++i], &end) : 0;
+            if (!end || *end != '\0' || !(rate > 0 && rate <= 1)) {
+                ShowUsage();
+            }
+            sampleRate = rate;
+            missRatioCurveMode = true;
+            continue;
+        }
+
+        // Fixed-size sampled miss ratio curve: --sample-max S, S >= 2 (implies --mrc)
+        if (!strcmp(arg, "--sample-max")) {
+            char *end = nullptr;
+            long long pages = i + 1 < argc ? strtoll(argv[++i], &end, 10) : 0;
+            if (!end || *end != '\0' || pages < 2) {
+                ShowUsage();
+            }
+            sampleMaxPages = pages;
+            missRatioCurveMode = true;
+            continue;
+        }
+
+        // Sweep mode: --frames SPEC and/or --page-size SPEC
+        if (!strcmp(arg, "--frames") || !strcmp(arg, "--page-size")) {
+            vector<size_t> &values = arg[2] == 'f' ? sweepFrameCounts : sweepPageSizes;
+            if (i + 1 >= argc || !ParseSweepList(argv[++i], values)) {
+                ShowUsage();
+            }
+            continue;
+        }
+
+        // Benchmark mode: --bench with --pages LIST, --refs N, --seed N and --generator NAMES
+        if (!strcmp(arg, "--bench")) {
+            benchmarkMode = true;
+            continue;
+        }
+        if (!strcmp(arg, "--scaling")) {
+            benchmarkMode = benchScaling = true;
+            continue;
+        }
+        if (!strcmp(arg, "--pages")) {
+            if (i + 1 >= argc || !ParseSweepList(argv[++i], benchPageCounts)) {
+                ShowUsage();
+            }
+            continue;
+        }
+        if (!strcmp(arg, "--refs") || !strcmp(arg, "--seed")) {
+            char *end = nullptr;
+            long long value = i + 1 < argc ? strtoll(argv[++i], &end, 10) : 0;
+            if (!end || *end != '\0' || value < 1 || (arg[2] == 'r' && value > INT_MAX)) {
+                ShowUsage();
+            }
+            if (arg[2] == 'r') {
+                benchReferences = value;
+            } else {
+                benchSeed = value;
+            }
+            continue;
+        }
+        if (!strcmp(arg, "--generator")) {
+            if (i + 1 >= argc) {
+                ShowUsage();
+            }
+            string_view rest(argv[++i]);
+            while (!rest.empty()) {
+                size_t comma = rest.find(',');
+                string_view name = rest.substr(0, comma);
+                rest = comma == string_view::npos ? string_view() : rest.substr(comma + 1);
+                int kind = 0;
+                while (kind < GENERATOR_COUNT && name != GENERATOR_NAMES[kind]) kind++;
+                if (kind == GENERATOR_COUNT) {
+                    ShowUsage();
+                }
+                benchGenerators[kind] = true;
+            }
+            continue;
+        }
+
+        // Time series: --interval N, --interval-format csv|ndjson, --interval-file PATH
+        if (!strcmp(arg, "--interval")) {
+            char *end = nullptr;
+            long length = i + 1 < argc ? strtol(argv[++i], &end, 10) : 0;
+            if (!end || *end != '\0' || length < 1 || length > INT_MAX) {
+                ShowUsage();
+            }
+            intervalLength = length;
+            continue;
+        }
+        if (!strcmp(arg, "--interval-format")) {
+            if (i + 1 >= argc || (strcmp(argv[i + 1], "csv") && strcmp(argv[i + 1], "ndjson"))) {
+                ShowUsage();
+            }
+            intervalNdjson = !strcmp(argv[++i], "ndjson");
+            continue;
+        }
+        if (!strcmp(arg, "--interval-file")) {
+            if (i + 1 >= argc) {
+                ShowUsage();
+            }
+            intervalFilename = argv[++i];
+            continue;
+        }
+
+        // Text trace parsing workers: --parse-threads N (0 parses on the simulation thread)
+        if (!strcmp(arg, "--parse-threads")) {
+            char *end = nullptr;
+            long threads = i + 1 < argc ? strtol(argv[++i], &end, 10) : -1;
+            if (!end || *end != '\0' || threads < 0 || threads > 256) {
+                ShowUsage();
+            }
+            parseThreads = threads;
+            continue;
+        }
+
+        // Checkpoints: --checkpoint-every N, --checkpoint-file PATH, --resume PATH
+        if (!strcmp(arg, "--checkpoint-every")) {
+            char *end = nullptr;
+            long long records = i + 1 < argc ? strtoll(argv[++i], &end, 10) : 0;
+            if (!end || *end != '\0' || records < 1) {
+                ShowUsage();
+            }
+            checkpointInterval = records;
+            continue;
+        }
+        if (!strcmp(arg, "--checkpoint-file")) {
+            if (i + 1 >= argc) {
+                ShowUsage();
+            }
+            checkpointFilename = argv[++i];
+            continue;
+        }
+        if (!strcmp(arg, "--resume")) {
+            if (i + 1 >= argc) {
+                ShowUsage();
+            }
+            resumeFilename = argv[++i];
+            continue;
+        }
+
+        // Prefetching: --prefetch next|stride|history, --prefetch-degree N
+        if (!strcmp(arg, "--prefetch")) {
+            int policy = PREFETCH_NONE;
+            while (i + 1 < argc && policy <= PREFETCH_HISTORY && strcmp(argv[i + 1], PREFETCH_NAMES[policy])) {
+                policy++;
+            }
+            if (i + 1 >= argc || policy > PREFETCH_HISTORY) {
+                ShowUsage();
+            }
+            prefetchPolicy = PrefetchPolicy(policy);
+            i++;
+            continue;
+        }
+        if (!strcmp(arg, "--prefetch-degree")) {
+            char *end = nullptr;
+            long degree = i + 1 < argc ? strtol(argv[++i], &end, 10) : 0;
+            if (!end || *end != '\0' || degree < 1 || degree > 64) {
+                ShowUsage();
+            }
+            prefetchDegree = degree;
+            continue;
+        }
+
+        // Real swap I/O: --swap-file PATH, --swap-threads N
+        if (!strcmp(arg, "--swap-file")) {
+            if (i + 1 >= argc) {
+                ShowUsage();
+            }
+            swapFilename = argv[++i];
+            continue;
+        }
+        if (!strcmp(arg, "--swap-threads")) {
+            char *end = nullptr;
+            long threads = i + 1 < argc ? strtol(argv[++i], &end, 10) : 0;
+            if (!end || *end != '\0' || threads < 1 || threads > 256) {
+                ShowUsage();
+            }
+            swapThreads = threads;
+            continue;
+        }
+
+        // Page-out daemon: --watermarks LOW,HIGH (free frames)
+        if (!strcmp(arg, "--watermarks")) {
+            char *end = nullptr;
+            long low = i + 1 < argc ? strtol(argv[++i], &end, 10) : 0;
+            long high = end && *end == ',' ? strtol(end + 1, &end, 10) : 0;
+            if (!end || *end != '\0' || low < 1 || high < low) {
+                ShowUsage();
+            }
+            lowWatermark = low;
+            highWatermark = high;
+            continue;
+        }
+
+        // Huge pages: --huge-pages N (base pages each, a power of two), --huge-threshold PERCENT
+        if (!strcmp(arg, "--huge-pages")) {
+            char *end = nullptr;
+            long span = i + 1 < argc ? strtol(argv[++i], &end, 10) : 0;
+            if (!end || *end != '\0' || span < 2 || span > (1 << 20) || (span & (span - 1)) != 0) {
+                ShowUsage();
+            }
+            for (hugePageShift = 0; (1L << hugePageShift) < span; hugePageShift++) {
+            }
+            continue;
+        }
+        if (!strcmp(arg, "--huge-threshold")) {
+            char *end = nullptr;
+            long percent = i + 1 < argc ? strtol(argv[++i], &end, 10) : 0;
+            if (!end || *end != '\0' || percent < 1 || percent > 100) {
+                ShowUsage();
+            }
+            hugePromoteThreshold = percent;
+            continue;
+        }
+
+        // NUMA: --numa N, --numa-placement first-touch|interleave|preferred, --numa-preferred NODE,
+        // --numa-replacement local|global, --numa-migrate
+        if (!strcmp(arg, "--numa")) {
+            char *end = nullptr;
+            long nodes = i + 1 < argc ? strtol(argv[++i], &end, 10) : 0;
+            if (!end || *end != '\0' || nodes < 2 || nodes > 64) {
+                ShowUsage();
+            }
+            numaNodes = nodes;
+            continue;
+        }
+        if (!strcmp(arg, "--numa-placement")) {
+            int placement = NUMA_FIRST_TOUCH;
+            while (i + 1 < argc && placement <= NUMA_PREFERRED && strcmp(argv[i + 1], NUMA_PLACEMENT_NAMES[placement])) {
+                placement++;
+            }
+            if (i + 1 >= argc || placement > NUMA_PREFERRED) {
+                ShowUsage();
+            }
+            numaPlacement = NumaPlacement(placement);
+            i++;
+            continue;
+        }
+        if (!strcmp(arg, "--numa-preferred")) {
+            char *end = nullptr;
+            long node = i + 1 < argc ? strtol(argv[++i], &end, 10) : -1;
+            if (!end || *end != '\0' || node < 0 || node > 63) {
+                ShowUsage();
+            }
+            numaPreferredNode = node;
+            continue;
+        }
+        if (!strcmp(arg, "--numa-replacement")) {
+            if (i + 1 >= argc || (strcmp(argv[i + 1], "local") && strcmp(argv[i + 1], "global"))) {
+                ShowUsage();
+            }
+            numaLocalReplacement = !strcmp(argv[++i], "local");
+            continue;
+        }
+        if (!strcmp(arg, "--numa-migrate")) {
+            numaMigrate = true;
+            continue;
+        }
+
+        // Working-set window: --tau N (references of virtual time)
+        if (!strcmp(arg, "--tau")) {
+            char *end = nullptr;
+            long tau = i + 1 < argc ? strtol(argv[++i], &end, 10) : 0;
+            if (!end || *end != '\0' || tau < 1 || tau > 100000000) {
+                ShowUsage();
+            }
+            workingSetWindow = tau;
+            continue;
+        }
+
+        // Conversion mode: --convert textfile binaryfile
+        if (!strcmp(arg, "--convert")) {
+            if (i + 2 >= argc || inputFilename) {
+                ShowUsage();
+            }
+            inputFilename = argv[++i];
+            convertOutputFilename = argv[++i];
+            continue;
+        }
+
+        // Handle flags
+        if (arg[0] == '-') {
+            // Validate flag format (single character)
+            if (!arg[1] || arg[2]) {
+                ShowUsage();
+            }
+
+            if (arg[1] == 'd') {
+                debugMode = 1;
+                debugRequested = true;
+            }
+            else if (arg[1] == 'w') {
+                backingStoreEnabled = true;
+            }
+            else if (arg[1] == 'f') {
+                releaseRetiredPages = true;
+            }
+            else if (arg[1] == 'x') {
+                wideAddresses = true;
+            }
+            else {
+                ShowUsage();
+            }
+            continue;
+        }
+
+        // Use array lookup for algorithm validation
+        static const struct { const char* name; bool* found; } VALID_ALGORITHMS[] = {
+            {"FIFO", &algorithmSpecified},
+            {"LRU", &algorithmSpecified},
+            {"OPTIMAL", &algorithmSpecified},
+            {"CLOCK", &algorithmSpecified},
+            {"ESC", &algorithmSpecified},
+            {"ARC", &algorithmSpecified},
+            {"2Q", &algorithmSpecified},
+            {"LIRS", &algorithmSpecified},
+            {"WS", &algorithmSpecified},
+            {"WSCLOCK", &algorithmSpecified},
+            {"ALL", &algorithmSpecified}
+        };
+
+        // Try to match algorithm first
+        if (!algorithmSpecified) {
+            bool matched = false;
+            for (const auto& valid : VALID_ALGORITHMS) {
+                if (!strcmp(arg, valid.name)) {
+                    replacementAlgorithm = arg;
+                    replacementPolicy = ResolveReplacementPolicy(arg);
+                    *valid.found = true;
+                    matched = true;
+                    break;
+                }
+            }
+            if (matched) {
+                continue;
+            }
+        }
+
+        // If not algorithm and no filename yet, treat as filename
+        if (!inputFilename) {
+            inputFilename = arg;
+        } else {
+            ShowUsage();
+        }
+    }
+
+    // Verify we got required parameters
+    if (convertOutputFilename) {
+        return;
+    }
+    if (missRatioCurveMode) {
+        if (algorithmSpecified && replacementPolicy != POLICY_LRU) {
+            ShowUsage();
+        }
+        replacementAlgorithm = "LRU";
+        replacementPolicy = POLICY_LRU;
+        algorithmSpecified = true;
+    }
+    if (benchmarkMode && algorithmSpecified && !inputFilename) {
+        return;
+    }
+    if (!algorithmSpecified || !inputFilename) {
+        ShowUsage();
+    }
+
+    // A prefetched page has no next use for OPTIMAL to order it by (ALL runs OPTIMAL without)
+    if (prefetchPolicy != PREFETCH_NONE && replacementPolicy == POLICY_OPTIMAL) {
+        ShowUsage();
+    }
+
+    // The preferred node must exist; ARC, 2Q and LIRS cannot pick a victim on a given node
+    // (ALL runs them with global replacement)
+    if (numaNodes && numaPreferredNode >= numaNodes) {
+        ShowUsage();
+    }
+    if (numaLocalReplacement && (replacementPolicy == POLICY_ARC || replacementPolicy == POLICY_2Q ||
+                                 replacementPolicy == POLICY_LIRS)) {
+        ShowUsage();
+    }
+
+    // Pages a promotion fills have no next use either (ALL runs OPTIMAL with base pages only)
+    if (hugePageShift && replacementPolicy == POLICY_OPTIMAL) {
+        ShowUsage();
+    }
+
+    // Policies whose victims depend on the incoming page or the future cannot free frames early
+    // (ALL runs them without the daemon)
+    if (lowWatermark && (replacementPolicy == POLICY_OPTIMAL || replacementPolicy == POLICY_ARC ||
+                         replacementPolicy == POLICY_2Q || replacementPolicy == POLICY_LIRS)) {
+        ShowUsage();
+    }
+
+    // The swap file backs the -w backing store of one single-policy replay
+    if (swapFilename && (!backingStoreEnabled || missRatioCurveMode || benchmarkMode || !sweepFrameCounts.empty() ||
+                         !sweepPageSizes.empty() || replacementPolicy == POLICY_ALL)) {
+        ShowUsage();
+    }
+
+    // Snapshots cover one single-policy replay of a trace file
+    if (checkpointInterval || resumeFilename) {
+        if (missRatioCurveMode || benchmarkMode || !sweepFrameCounts.empty() || !sweepPageSizes.empty() ||
+            replacementPolicy == POLICY_ALL) {
+            ShowUsage();
+        }
+        if (checkpointFilename.empty()) {
+            checkpointFilename = string(inputFilename) + ".checkpoint";
+        }
+    }
+}
+
+void LoadInputFile() {
+    int fd = open(inputFilename, O_RDONLY);
+    if (fd == -1) {
+        cerr << "Error: Cannot open file " << inputFilename << endl;
+        exit(1);
+    }
+
+    // Map regular files so references are parsed in place as the simulation reaches them
+    struct stat fileInfo;
+    if (fstat(fd, &fileInfo) == 0 && S_ISREG(fileInfo.st_mode) && fileInfo.st_size > 0) {
+        void *mapping = mmap(nullptr, fileInfo.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping != MAP_FAILED) {
+            madvise(mapping, fileInfo.st_size, MADV_SEQUENTIAL);
+            traceData = static_cast<const char *>(mapping);
+            traceSize = fileInfo.st_size;
+            traceIsMapped = true;
+        }
+    }
+
+    // Pipes and other unmappable inputs are read in large chunks into one buffer
+    if (!traceIsMapped) {
+        const size_t chunkSize = 1 << 20;
+        ssize_t bytesRead;
+        do {
+            size_t used = traceBuffer.size();
+            traceBuffer.resize(used + chunkSize);
+            bytesRead = read(fd, traceBuffer.data() + used, chunkSize);
+            traceBuffer.resize(used + (bytesRead > 0 ? bytesRead : 0));
+        } while (bytesRead > 0);
+        traceData = traceBuffer.data();
+        traceSize = traceBuffer.size();
+    }
+    close(fd);
+
+    // Binary traces carry the configuration in a fixed header
+    if (traceSize >= sizeof(BinaryTraceHeader) && memcmp(traceData, BINARY_TRACE_MAGIC, sizeof(BINARY_TRACE_MAGIC)) == 0) {
+        BinaryTraceHeader header;
+        memcpy(&header, traceData, sizeof(header));
+        pageSize = header.pageSize;
+        totalFrames = header.numFrames;
+        totalPages = header.numPages;
+        totalBackingStoreBlocks = header.numBackingBlocks;
+        traceBodyOffset = sizeof(header);
+        binaryTrace = true;
+    }
+
+    // Read the first line (skip comments)
+    string_view line;
+    while (!binaryTrace && NextTraceLine(traceBodyOffset, line)) {
+        // Skip comments and empty lines
+        if (line.empty() || line[0] == '#') continue;
+
+        initialConfigLine = string(line);
+
+        istringstream iss(initialConfigLine);
+        // Read pageSize, numFrame, numPage, numBackingStoreBlocks
+        if (!(iss >> pageSize >> totalFrames >> totalPages >> totalBackingStoreBlocks)) {
+            cerr << "Error: Invalid format in the first line." << endl;
+            exit(1);
+        }
+        break;
+    }
+
+    // Check if the necessary variables are set
+    if (pageSize == 0 || totalFrames == 0 || totalPages == 0) {
+        cerr << "Error: Missing or invalid page size, number of frames, or number of pages." << endl;
+        exit(1);
+    }
+    if (totalFrames > MAX_FRAMES) {
+        cerr << "Error: Number of frames exceeds the maximum of " << MAX_FRAMES << "." << endl;
+        exit(1);
+    }
+}
+
+// Function to return the next line of the trace without copying it (same splitting as getline)
+bool NextTraceLine(size_t &offset, string_view &line) {
+    if (offset >= traceSize) return false;
+
+    const char *start = traceData + offset;
+    const char *newline = static_cast<const char *>(memchr(start, '\n', traceSize - offset));
+    size_t length = newline ? newline - start : traceSize - offset;
+
+    line = string_view(start, length);
+    offset += length + 1;
+    return true;
+}
+
+// Function to read a base-128 varint from the trace in place
+static inline bool ReadVarint(size_t &offset, uint64_t &value) {
+    value = 0;
+    for (int shift = 0; offset < traceSize && shift < 64; shift += 7) {
+        uint8_t byte = traceData[offset++];
+        value |= uint64_t(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;  // Truncated record
+}
+
+// Function to decode the next binary trace record in place
+bool NextBinaryRecord(size_t &offset, long long &previousAddress, TraceRecord &record) {
+    uint64_t tag;
+    if (!ReadVarint(offset, tag)) return false;
+
+    uint64_t zigzagDelta = tag >> 2;
+    switch (tag & 3) {
+    case 2: {
+        static const RecordKind DIRECTIVES[] = {RECORD_PRINT, RECORD_DEBUG, RECORD_NODEBUG, RECORD_BAD_FORMAT};
+        record.kind = DIRECTIVES[zigzagDelta & 3];
+        return true;
+    }
+    case 3:
+        record.operation = (zigzagDelta & 1) ? 'w' : 'r';
+        record.cpu = (unsigned short)(zigzagDelta >> 1);
+        if (!ReadVarint(offset, zigzagDelta)) return false;
+        break;
+    default:
+        record.operation = (tag & 1) ? 'w' : 'r';
+        record.cpu = 0;
+        break;
+    }
+
+    previousAddress += (long long)((zigzagDelta >> 1) ^ (0 - (zigzagDelta & 1)));
+    record.kind = RECORD_REFERENCE;
+    record.memLocation = previousAddress;
+    return true;
+}
+
+// Function to fetch the next record from either trace format
+bool NextTraceRecord(size_t &offset, long long &previousAddress, TraceRecord &record) {
+    if (binaryTrace) {
+        return NextBinaryRecord(offset, previousAddress, record);
+    }
+
+    string_view line;
+    if (!NextTraceLine(offset, line)) return false;
+    record = ParseInputLine(line);
+    return true;
+}
+
+void ProcessAllInputLines(TracePosition position, Page *pageTable, Frame *frameTable) {
+    // Large text traces are parsed ahead on worker threads, unless snapshots need exact offsets
+    if (!binaryTrace && checkpointInterval == 0) {
+        size_t remainingChunks = (traceSize - min(position.offset, traceSize)) / PARSE_CHUNK_BYTES;
+        int workerCount = parseThreads >= 0 ? parseThreads
+                        : remainingChunks >= 4 ? min(4, (int)thread::hardware_concurrency() - 1) : 0;
+        if (workerCount > 0) {
+            ProcessChunkedInputLines(position, workerCount, pageTable, frameTable);
+            return;
+        }
+    }
+
+    // Binary traces decode straight into the simulator
+    if (binaryTrace) {
+        TraceRecord record;
+        while (NextBinaryRecord(position.offset, position.previousAddress, record)) {
+            ProcessTraceRecord(record, position.recordIndex++, pageTable, frameTable);
+            if (checkpointInterval && position.recordIndex % checkpointInterval == 0) {
+                WriteCheckpoint(position, pageTable, frameTable);
+            }
+        }
+        return;
+    }
+
+    // Process each line straight out of the trace
+    string_view line;
+    while (NextTraceLine(position.offset, line)) {
+        ProcessInputLine(line, position.recordIndex++, pageTable, frameTable);
+        if (checkpointInterval && position.recordIndex % checkpointInterval == 0) {
+            WriteCheckpoint(position, pageTable, frameTable);
+        }
+    }
+}
+
+// Function to find where a chunk of the trace starts: the first line beginning at or after
+// baseOffset + chunk * PARSE_CHUNK_BYTES, so each line belongs to exactly one chunk
+size_t TraceChunkStart(size_t baseOffset, size_t chunk) {
+    if (chunk == 0) return baseOffset;
+    size_t offset = baseOffset + chunk * PARSE_CHUNK_BYTES - 1;
+    if (offset >= traceSize) return traceSize;
+    const char *newline = static_cast<const char *>(memchr(traceData + offset, '\n', traceSize - offset));
+    return newline ? newline - traceData + 1 : traceSize;
+}
+
+// Function run by each parse worker: claim the next chunk, wait for its slot to drain, and
+// parse the chunk's lines into page numbers
+void ParseTraceChunks(size_t baseOffset, size_t chunkCount, vector<ParsedChunk> &slots, atomic<size_t> &nextChunk,
+                      size_t parserPageSize, size_t parserPages) {
+    // Page numbering reads the geometry, which is per thread
+    pageSize = parserPageSize;
+    totalPages = parserPages;
+
+    for (size_t chunk = nextChunk++; chunk < chunkCount; chunk = nextChunk++) {
+        ParsedChunk &slot = slots[chunk % slots.size()];
+        while (slot.freeFor.load(memory_order_acquire) != chunk) {
+            this_thread::yield();
+        }
+
+        slot.records.clear();
+        slot.invalidRecords.clear();
+        size_t offset = TraceChunkStart(baseOffset, chunk);
+        size_t end = TraceChunkStart(baseOffset, chunk + 1);
+        string_view line;
+        while (offset < end && NextTraceLine(offset, line)) {
+            TraceRecord record = ParseInputLine(line);
+            long long pageNumber = record.kind == RECORD_REFERENCE ? PageNumberFor(record.memLocation) : -1;
+            slot.records.push_back({pageNumber, record.operation, record.kind, record.cpu});
+            if (record.kind > RECORD_REFERENCE) {
+                slot.invalidRecords.push_back(record);
+            }
+        }
+        slot.parsed.store(chunk + 1, memory_order_release);
+    }
+}
+
+// Function to replay a text trace parsed by worker threads, taking the chunks in trace order
+// from a bounded ring so directives and error messages keep their exact positions
+void ProcessChunkedInputLines(TracePosition position, int workerCount, Page *pageTable, Frame *frameTable) {
+    size_t baseOffset = position.offset;
+    size_t chunkCount = (traceSize - baseOffset + PARSE_CHUNK_BYTES - 1) / PARSE_CHUNK_BYTES;
+
+    // Two slots per worker keep every worker busy while the simulation drains the oldest chunk
+    vector<ParsedChunk> slots(2 * workerCount);
+    for (size_t i = 0; i < slots.size(); i++) {
+        slots[i].freeFor.store(i, memory_order_relaxed);
+    }
+    atomic<size_t> nextChunk(0);
+    vector<thread> workers;
+    for (int i = 0; i < workerCount; i++) {
+        workers.emplace_back(ParseTraceChunks, baseOffset, chunkCount, ref(slots), ref(nextChunk),
+                             (size_t)pageSize, (size_t)totalPages);
+    }
+
+    size_t lineIndex = position.recordIndex;
+    for (size_t chunk = 0; chunk < chunkCount; chunk++) {
+        ParsedChunk &slot = slots[chunk % slots.size()];
+        while (slot.parsed.load(memory_order_acquire) != chunk + 1) {
+            this_thread::yield();
+        }
+
+        size_t invalidIndex = 0;
+        for (const ChunkRecord &record : slot.records) {
+            if (record.kind > RECORD_REFERENCE) {
+                ReportInvalidRecord(slot.invalidRecords[invalidIndex++], lineIndex);
+            }
+            SimulateRecord(record.kind, record.operation, record.pageNumber, record.cpu, lineIndex++, pageTable, frameTable);
+        }
+        slot.freeFor.store(chunk + slots.size(), memory_order_release);
+    }
+
+    for (thread &worker : workers) {
+        worker.join();
+    }
+}
+
+// Snapshots copy raw bytes in both directions, so one routine lists the state for save and load
+static void TransferBytes(ostream &out, void *data, size_t size) {
+    out.write(static_cast<const char *>(data), size);
+}
+
+static void TransferBytes(istream &in, void *data, size_t size) {
+    in.read(static_cast<char *>(data), size);
+}
+
+template <typename Stream, typename T>
+static void TransferValue(Stream &stream, T &value) {
+    TransferBytes(stream, &value, sizeof(value));
+}
+
+template <typename Stream, typename T>
+static void TransferVector(Stream &stream, vector<T> &values) {
+    uint64_t count = values.size();
+    TransferValue(stream, count);
+    if (!stream) return;
+    values.resize(count);
+    TransferBytes(stream, values.data(), count * sizeof(T));
+}
+
+static void TransferMap(ostream &out, unordered_map<long long, int> &values) {
+    uint64_t count = values.size();
+    TransferValue(out, count);
+    for (auto &entry : values) {
+        long long key = entry.first;
+        TransferValue(out, key);
+        TransferValue(out, entry.second);
+    }
+}
+
+static void TransferMap(istream &in, unordered_map<long long, int> &values) {
+    uint64_t count = 0;
+    TransferValue(in, count);
+    values.clear();
+    values.reserve(count);
+    for (uint64_t i = 0; i < count && in; i++) {
+        long long key;
+        int value;
+        TransferValue(in, key);
+        TransferValue(in, value);
+        values.emplace(key, value);
+    }
+}
+
+// Function to save or load everything a simulation carries from one reference to the next,
+// except the sparse page table, which is walked separately
+template <typename Stream>
+static void TransferSimulationState(Stream &stream, Page *pageTable, Frame *frameTable) {
+    TransferValue(stream, debugMode);
+    TransferValue(stream, totalPageReferences);
+    TransferValue(stream, totalPagesMapped);
+    TransferValue(stream, totalPageMisses);
+    TransferValue(stream, totalFramesStolen);
+    TransferValue(stream, totalFramesWrittenToDisk);
+    TransferValue(stream, totalFramesRecoveredFromDisk);
+    TransferValue(stream, referenceHeapAllocations);
+
+    if (pageTable != nullptr) {
+        TransferBytes(stream, pageTable, totalPages * sizeof(Page));
+    }
+    TransferBytes(stream, frameTable, totalFrames * sizeof(Frame));
+
+    if (backingStoreTable != nullptr) {
+        TransferBytes(stream, backingStoreTable, totalBackingStoreBlocks * sizeof(BackingStoreBlock));
+    }
+    TransferValue(stream, backingStoreBlocksInUse);
+    TransferValue(stream, backingStoreBlocksRead);
+    TransferValue(stream, backingStoreBlocksWritten);
+    TransferValue(stream, backingStoreBlocksReleased);
+    TransferValue(stream, backingStoreBlocksReused);
+    TransferValue(stream, backingStoreBlocksPeak);
+    TransferValue(stream, retiredPageWritesAvoided);
+    for (vector<uint64_t> &level : freeBlockBitmap) {
+        TransferVector(stream, level);
+    }
+    TransferVector(stream, pageBackingStoreBlock);
+    TransferMap(stream, sparsePageBackingStoreBlock);
+
+    TransferValue(stream, nextUnusedFrame);
+    TransferValue(stream, leastRecentFrame);
+    TransferValue(stream, mostRecentFrame);
+    TransferVector(stream, optimalHeap);
+    TransferVector(stream, optimalHeapPosition);
+    TransferVector(stream, frameNextUse);
+
+    TransferValue(stream, clockHand);
+    TransferValue(stream, clockHandAdvances);
+    TransferValue(stream, clockHandRevolutions);
+    TransferValue(stream, clockReferenceBitsCleared);
+    TransferValue(stream, clockDirtyFramesSkipped);
+    TransferValue(stream, clockCleanVictims);
+    TransferValue(stream, clockDirtyVictims);
+
+    TransferVector(stream, freeFrames);
+    TransferValue(stream, workingSetTrims);
+    TransferValue(stream, workingSetFramesSkipped);
+    TransferValue(stream, workingSetCleaningWrites);
+    TransferVector(stream, workingSetRing);
+    TransferVector(stream, pageLastReference);
+    TransferMap(stream, sparsePageLastReference);
+    TransferValue(stream, workingSetTime);
+    TransferValue(stream, workingSetSize);
+    TransferValue(stream, workingSetPeak);
+    TransferValue(stream, workingSetSizeSum);
+    TransferValue(stream, workingSetSamples);
+
+    TransferValue(stream, intervalStart);
+    TransferValue(stream, intervalIndex);
+    TransferValue(stream, intervalDistinctPages);
+    TransferVector(stream, pageLastInterval);
+    TransferMap(stream, sparsePageLastInterval);
+
+    TransferVector(stream, policyNodes);
+    TransferVector(stream, freePolicyNodes);
+    TransferBytes(stream, policyLists, sizeof(policyLists));
+    TransferVector(stream, policyNodeOfPage);
+    TransferMap(stream, sparsePolicyNodeOfPage);
+    TransferValue(stream, arcTargetT1);
+    TransferValue(stream, twoQueueKin);
+    TransferValue(stream, twoQueueKout);
+    TransferValue(stream, lirsLirLimit);
+    TransferValue(stream, lirsLirCount);
+
+    TransferValue(stream, prefetchesIssued);
+    TransferValue(stream, prefetchesUsed);
+    TransferValue(stream, prefetchesEvictedUnused);
+    TransferValue(stream, prefetchPollutionMisses);
+    TransferValue(stream, prefetchSwapReads);
+    TransferValue(stream, strideLastMiss);
+    TransferValue(stream, strideLastDelta);
+    TransferValue(stream, historyLastMiss);
+    TransferVector(stream, prefetchHistory);
+    TransferVector(stream, pollutedPageBits);
+
+    TransferValue(stream, framesInUse);
+    TransferValue(stream, pageOutWakeups);
+    TransferValue(stream, pageOutReclaims);
+    TransferValue(stream, pageOutReclaimWrites);
+    TransferValue(stream, pageOutCleanings);
+    TransferValue(stream, pageOutExtraWrites);
+
+    TransferVector(stream, regionState);
+    TransferMap(stream, sparseRegionState);
+    TransferValue(stream, hugePromotions);
+    TransferValue(stream, hugePromotionsDeferred);
+    TransferValue(stream, hugeDemotions);
+    TransferValue(stream, hugePagesMapped);
+    TransferValue(stream, hugePageReferences);
+    TransferValue(stream, hugeFillFrames);
+    TransferValue(stream, hugeFillSwapReads);
+    TransferValue(stream, hugeFillsEvictedUntouched);
+    TransferValue(stream, hugeUntouchedFrames);
+    TransferValue(stream, hugeUntouchedPeak);
+
+    for (vector<int> &pool : nodeFreeFrames) {
+        TransferVector(stream, pool);
+    }
+    TransferVector(stream, nodeNextUnusedFrame);
+    TransferVector(stream, numaCounters);
+}
+
+// Function to describe the configuration a snapshot belongs to
+void BuildCheckpointHeader(CheckpointHeader &header) {
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic));
+    memcpy(header.algorithm, replacementAlgorithm, min(strlen(replacementAlgorithm), sizeof(header.algorithm)));
+    header.pageSize = pageSize;
+    header.numFrames = totalFrames;
+    header.numPages = totalPages;
+    header.numBackingBlocks = totalBackingStoreBlocks;
+    header.traceSize = traceSize;
+    header.workingSetWindow = workingSetWindow;
+    header.options = (backingStoreEnabled ? 1 : 0) | (releaseRetiredPages ? 2 : 0) | (wideAddresses ? 4 : 0);
+    header.prefetchPolicy = prefetchPolicy;
+    header.prefetchDegree = prefetchDegree;
+    header.lowWatermark = lowWatermark;
+    header.highWatermark = highWatermark;
+    header.hugePageShift = hugePageShift;
+    header.hugePromoteThreshold = hugePromoteThreshold;
+    header.numaNodes = numaNodes;
+    header.numaPlacement = numaPlacement;
+    header.numaPreferredNode = numaPreferredNode;
+    header.numaOptions = (numaLocalReplacement ? 1 : 0) | (numaMigrate ? 2 : 0);
+}
+
+// Function to snapshot the simulation without stalling it: a forked child writes its
+// copy-on-write view of the tables while the parent keeps simulating
+void WriteCheckpoint(const TracePosition &position, Page *pageTable, Frame *frameTable) {
+    // At most one writer is in flight, so snapshots land in order
+    WaitForCheckpointWriter();
+
+    // The interval file gets every row up to here, and the snapshot records how long it is
+    if (intervalFd != -1) {
+        FlushIntervalRows();
+        intervalFileLength = lseek(intervalFd, 0, SEEK_END);
+    }
+
+    // The child leaves through _exit, so it never flushes the report output it inherited
+    pid_t pid = fork();
+    if (pid > 0) {
+        checkpointWriter = pid;
+        return;
+    }
+    bool saved = SaveCheckpoint(position, pageTable, frameTable);
+    if (pid == 0) {
+        _exit(saved ? 0 : 1);
+    }
+
+    // fork failed, so the snapshot was written inline
+    if (!saved) {
+        exit(1);
+    }
+}
+
+// Function to write a snapshot next to its final name and move it into place, so a crash
+// mid-write leaves the previous snapshot intact
+bool SaveCheckpoint(const TracePosition &position, Page *pageTable, Frame *frameTable) {
+    string temporaryFilename = checkpointFilename + ".tmp";
+    ofstream out(temporaryFilename, ios::binary | ios::trunc);
+    if (!out.is_open()) {
+        cerr << "Error: Cannot open file " << temporaryFilename << endl;
+        return false;
+    }
+
+    CheckpointHeader header;
+    BuildCheckpointHeader(header);
+    TransferValue(out, header);
+    TracePosition saved = position;
+    TransferValue(out, saved);
+    TransferValue(out, intervalFileLength);
+    TransferSimulationState(out, pageTable, frameTable);
+    if (wideAddresses) {
+        SaveSparsePageTable(out, radixRoot, radixHeight, 0);
+        long long endMarker = -1;
+        TransferValue(out, endMarker);
+    }
+
+    out.close();
+    if (!out || rename(temporaryFilename.c_str(), checkpointFilename.c_str()) != 0) {
+        cerr << "Error: Unable to write checkpoint " << checkpointFilename << endl;
+        return false;
+    }
+    return true;
+}
+
+// Function to reap the snapshot writer, stopping the run if its snapshot failed
+void WaitForCheckpointWriter() {
+    if (checkpointWriter == -1) return;
+
+    int status = 0;
+    waitpid(checkpointWriter, &status, 0);
+    checkpointWriter = -1;
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        exit(1);  // The writer already explained why
+    }
+}
+
+// Function to save the touched entries of the radix table as (page, entry) pairs, each
+// followed by the leaf's prefetch pollution word that covers it
+void SaveSparsePageTable(ostream &out, void *node, int level, long long basePage) {
+    if (node == nullptr) return;
+    if (level == 1) {
+        PageLeaf *leaf = static_cast<PageLeaf *>(node);
+        for (int i = 0; i < RADIX_FANOUT; i++) {
+            if (leaf->entries[i].status != PAGE_UNUSED) {
+                long long pageNumber = basePage + i;
+                TransferValue(out, pageNumber);
+                TransferValue(out, leaf->entries[i]);
+                TransferValue(out, leaf->pollutedBits[i >> 6]);
+            }
+        }
+        return;
+    }
+    RadixNode *interior = static_cast<RadixNode *>(node);
+    for (int i = 0; i < RADIX_FANOUT; i++) {
+        SaveSparsePageTable(out, interior->slots[i], level - 1, basePage + ((long long)i << ((level - 1) * RADIX_BITS)));
+    }
+}
+
+// Function to restore a snapshot over freshly initialized tables and return where to continue
+void LoadCheckpoint(TracePosition &position, Page *pageTable, Frame *frameTable) {
+    ifstream in(resumeFilename, ios::binary);
+    if (!in.is_open()) {
+        cerr << "Error: Cannot open file " << resumeFilename << endl;
+        exit(1);
+    }
+
+    CheckpointHeader header, expected;
+    BuildCheckpointHeader(expected);
+    TransferValue(in, header);
+    if (!in || memcmp(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic)) != 0) {
+        cerr << "Error: " << resumeFilename << " is not a checkpoint" << endl;
+        exit(1);
+    }
+    if (memcmp(&header, &expected, sizeof(header)) != 0) {
+        cerr << "Error: Checkpoint " << resumeFilename << " was taken with a different trace, policy or options" << endl;
+        exit(1);
+    }
+
+    TransferValue(in, position);
+    TransferValue(in, intervalFileLength);
+    if (intervalFd != -1) {
+        struct stat status;
+        if (fstat(intervalFd, &status) != 0 || status.st_size < intervalFileLength) {
+            cerr << "Error: Interval file " << intervalFilename << " is shorter than checkpoint " << resumeFilename
+                 << " expects" << endl;
+            exit(1);
+        }
+        TruncateIntervalFile(intervalFileLength);
+    }
+    TransferSimulationState(in, pageTable, frameTable);
+    while (wideAddresses && in) {
+        long long pageNumber;
+        TransferValue(in, pageNumber);
+        if (pageNumber == -1) break;
+        TransferValue(in, SparsePageEntry(pageNumber));
+        TransferValue(in, cachedLeaf->pollutedBits[(pageNumber & (RADIX_FANOUT - 1)) >> 6]);
+    }
+
+    if (!in || in.peek() != EOF) {
+        cerr << "Error: Checkpoint " << resumeFilename << " is truncated or corrupt" << endl;
+        exit(1);
+    }
+}
+
+static void AppendVarint(vector<char> &out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(char((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(char(value));
+}
+
+// Function to convert the loaded text trace into the binary trace format
+void ConvertTraceToBinary() {
+    if (binaryTrace) {
+        cerr << "Error: " << inputFilename << " is already a binary trace" << endl;
+        exit(1);
+    }
+
+    ofstream outputFile(convertOutputFilename, ios::binary | ios::trunc);
+    if (!outputFile.is_open()) {
+        cerr << "Error: Cannot open file " << convertOutputFilename << endl;
+        exit(1);
+    }
+
+    BinaryTraceHeader header;
+    memcpy(header.magic, BINARY_TRACE_MAGIC, sizeof(header.magic));
+    header.pageSize = pageSize;
+    header.numFrames = totalFrames;
+    header.numPages = totalPages;
+    header.numBackingBlocks = totalBackingStoreBlocks;
+    outputFile.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+    size_t references = 0, directives = 0, bytesWritten = sizeof(header);
+    long long previousAddress = 0;
+    vector<char> buffer;
+    size_t offset = traceBodyOffset;
+    string_view line;
+    for (size_t lineIndex = 0; NextTraceLine(offset, line); lineIndex++) {
+        TraceRecord record = ParseInputLine(line);
+
+        if (record.kind == RECORD_REFERENCE) {
+            uint64_t op = record.operation == 'w' ? 1 : 0;
+            long long delta = (long long)(record.memLocation - previousAddress);
+            uint64_t zigzagDelta = (uint64_t(delta) << 1) ^ uint64_t(delta >> 63);
+            if (zigzagDelta < (uint64_t(1) << 62) && record.cpu == 0) {
+                AppendVarint(buffer, (zigzagDelta << 2) | op);
+            } else {
+                AppendVarint(buffer, ((uint64_t(record.cpu) << 1 | op) << 2) | 3);
+                AppendVarint(buffer, zigzagDelta);
+            }
+            previousAddress = record.memLocation;
+            references++;
+        } else if (record.kind != RECORD_SKIP) {
+            // Invalid lines still count as references, so keep a marker for them
+            uint64_t directive = record.kind == RECORD_PRINT ? 0 : record.kind == RECORD_DEBUG ? 1 : record.kind == RECORD_NODEBUG ? 2 : 3;
+            if (directive == 3) {
+                ReportInvalidRecord(record, lineIndex);
+            }
+            AppendVarint(buffer, (directive << 2) | 2);
+            directives++;
+        }
+
+        if (buffer.size() >= (1 << 20)) {
+            outputFile.write(buffer.data(), buffer.size());
+            bytesWritten += buffer.size();
+            buffer.clear();
+        }
+    }
+    outputFile.write(buffer.data(), buffer.size());
+    bytesWritten += buffer.size();
+
+    if (!outputFile) {
+        cerr << "Error: Failed writing " << convertOutputFilename << endl;
+        exit(1);
+    }
+
+    cout << "Converted " << inputFilename << " to " << convertOutputFilename << ": "
+         << references << " references, " << directives << " directives, "
+         << bytesWritten << " bytes" << endl;
+}
+
+void ReleaseResources(Page *pageTable, Frame *frameTable) {
+    // Clean up dynamically allocated memory
+    delete[] pageTable;
+    ReleaseSparsePageTable(radixRoot, radixHeight);
+    delete[] frameTable;
+    if (backingStoreTable != nullptr) {
+        delete[] backingStoreTable;
+    }
+}
+
+void ReleaseTrace() {
+    if (traceIsMapped) {
+        munmap(const_cast<char *>(traceData), traceSize);
+    }
+}
+
+void ExecutePageReplacement(long long currentPage, int &selectedFrame, Page *pageTable, Frame *frameTable) {
+    // Select a frame to replace using the replacement algorithm (on the placement node when
+    // replacement is node-local)
+    victimNode = numaNodeLocal ? numaTargetNode : -1;
+    selectedFrame = SelectFrameForReplacement(currentPage, pageTable, frameTable);
+    victimNode = -1;
+    if (selectedFrame == -1) return;
+    StealFrame(selectedFrame, pageTable, frameTable);
+    frameTable[selectedFrame].first_use = totalPageReferences;
+}
+
+// Function to take a frame away from the page that holds it, writing the page out if dirty
+void StealFrame(int selectedFrame, Page *pageTable, Frame *frameTable) {
+    // Handle the page being replaced (the frame table already knows its owner)
+    long long victimPage = frameTable[selectedFrame].pageNumber;
+    Page *victim = victimPage != -1 ? &PageEntry(pageTable, victimPage) : nullptr;
+    if (victim && victim->frameNumber == selectedFrame) {
+        victim->status = PAGE_STOLEN;
+        victim->frameNumber = -1;
+        if (frameTable[selectedFrame].isPrefetched) {
+            prefetchesEvictedUnused++;
+        }
+        if (hugePagesActive) {
+            ReleaseHugeRegionPage(victimPage, frameTable[selectedFrame]);
+        }
+
+        if (victim->lastOperation != OPERATION_NONE) {
+            if (victim->isRetired) {
+                // Nothing will read the page again, so its contents need not reach swap
+                if (victim->lastOperation == OPERATION_WRITE || frameTable[selectedFrame].isDirty == 1) {
+                    retiredPageWritesAvoided++;
+                }
+            } else if (victim->lastOperation == OPERATION_WRITE || frameTable[selectedFrame].isDirty == 1) {
+                WritePageToBackingStore(victimPage, *victim);
+                totalFramesWrittenToDisk++;
+            }
+        }
+
+        totalFramesStolen++;
+    }
+}
+
+// Function to record a page write to swap, giving the page a backing store block on its first write
+void WritePageToBackingStore(long long pageNumber, Page &page) {
+    page.isOnDisk = 1;
+
+    if (backingStoreEnabled) {
+        // If the page does not already have a backing store block
+        int pageBlock = BackingStoreBlockOf(pageNumber);
+        if (pageBlock == -1) {
+            int bsIndex = FindAvailableBackingStoreBlock();
+            if (bsIndex == -1) {
+                cerr << "Error: No free backing store blocks available." << endl;
+                exit(1);
+            }
+            if (backingStoreTable[bsIndex].writeCount != 0) {
+                backingStoreBlocksReused++;
+            }
+            MarkBackingStoreBlock(bsIndex, false);
+            backingStoreTable[bsIndex].isInUse = 1;
+            backingStoreTable[bsIndex].pageNumber = pageNumber;
+            backingStoreTable[bsIndex].writeCount++;
+            backingStoreBlocksInUse++;
+            backingStoreBlocksPeak = max(backingStoreBlocksPeak, backingStoreBlocksInUse);
+            backingStoreBlocksWritten++;
+            SetBackingStoreBlock(pageNumber, bsIndex);
+            if (swapFd != -1) {
+                SubmitSwapIo(true, bsIndex, pageNumber);
+            }
+        } else {
+            // Page already has a backing store block, increment writes
+            int bsIndex = pageBlock;
+            backingStoreTable[bsIndex].writeCount++;
+            backingStoreBlocksWritten++;
+            if (swapFd != -1) {
+                SubmitSwapIo(true, bsIndex, pageNumber);
+            }
+        }
+    }
+}
+
+int SelectFrameForReplacement(long long currentPage, Page *pageTable, Frame* frameTable) {
+    switch (replacementPolicy) {
+    case POLICY_FIFO:
+    case POLICY_LRU:
+    case POLICY_WS: {
+        // The head of the list always holds the smallest last_use (first_use under FIFO);
+        // node-local replacement walks on to the oldest frame of the victim node
+        int frameIndex = leastRecentFrame;
+        while (victimNode != -1 && FrameNode(frameIndex) != victimNode) {
+            frameIndex = frameTable[frameIndex].moreRecentFrame;
+        }
+        return frameIndex;
+    }
+    case POLICY_CLOCK:
+    case POLICY_ESC:
+    case POLICY_WSCLOCK:
+        return AdvanceClockHand(pageTable, frameTable);
+    case POLICY_ARC:
+    case POLICY_2Q:
+    case POLICY_LIRS:
+        return SelectAdaptiveVictim(currentPage);
+    default:
+        break;
+    }
+
+    // OPTIMAL: the top of the heap holds the frame whose page is used farthest in the future;
+    // node-local replacement searches the node's frames instead
+    if (victimNode != -1) {
+        int farthestFrame = NodeFirstFrame(victimNode);
+        for (size_t i = farthestFrame + 1; i < NodeFirstFrame(victimNode + 1); i++) {
+            if (frameNextUse[i] > frameNextUse[farthestFrame]) {
+                farthestFrame = i;
+            }
+        }
+        return farthestFrame;
+    }
+    return optimalHeap[0];
+}
+
+// Function to update frame and page tables after a reference
+void UpdateFrameAndPageEntries(long long currentPage, int selectedFrame, char operation, Page *pageTable, Frame *frameTable, bool isCacheHit) {
+    // Update the 'isDirty' flag based on cache hit and operation type
+    if (operation == 'w' || (isCacheHit && frameTable[selectedFrame].isDirty == 1)) {
+        frameTable[selectedFrame].isDirty = 1;
+    } else {
+        frameTable[selectedFrame].isDirty = 0;
+    }
+
+    // Update the frame number for the current page
+    PageEntry(pageTable, currentPage).frameNumber = selectedFrame;
+
+    // Mark the frame as in use; a reference (or a new page) ends a prefetched or untouched fill state
+    if (!frameTable[selectedFrame].isInUse) {
+        framesInUse++;
+    }
+    frameTable[selectedFrame].isInUse = 1;
+    frameTable[selectedFrame].isPrefetched = 0;
+    if (frameTable[selectedFrame].isHugeFill) {
+        frameTable[selectedFrame].isHugeFill = 0;
+        hugeUntouchedFrames--;
+    }
+
+    // A new page has no remote references yet
+    if (!isCacheHit) {
+        frameTable[selectedFrame].remoteNode = 0;
+    }
+
+    // A newly resident page counts toward its region's promotion
+    if (hugePagesActive && !isCacheHit) {
+        HugeRegionSlot(currentPage >> hugePageShift)++;
+    }
+
+    // Writing a page the daemon cleaned makes that write-back wasted
+    if (frameTable[selectedFrame].isCleaned && (operation == 'w' || !isCacheHit)) {
+        if (isCacheHit) {
+            pageOutExtraWrites++;
+        }
+        frameTable[selectedFrame].isCleaned = 0;
+    }
+
+    // Update the 'first_use' timestamp if it hasn't been set yet
+    if (frameTable[selectedFrame].first_use == -1) {
+        frameTable[selectedFrame].first_use = totalPageReferences;
+    } else {
+        frameTable[selectedFrame].first_use = frameTable[selectedFrame].first_use;
+    }
+
+    // Update the 'last_use' timestamp to the current reference count
+    frameTable[selectedFrame].last_use = totalPageReferences;
+
+    // Associate the frame with the current page
+    frameTable[selectedFrame].pageNumber = currentPage;
+}
+
+void HandlePageLoadingFromDisk(long long currentPage, bool isCacheHit, Page *pageTable) {
+    Page &page = PageEntry(pageTable, currentPage);
+    if (!isCacheHit && page.isOnDisk == 1) {
+        totalFramesRecoveredFromDisk++;
+        int bsIndex = backingStoreEnabled ? BackingStoreBlockOf(currentPage) : -1;
+        if (bsIndex != -1) {
+            backingStoreTable[bsIndex].readCount++;
+            backingStoreBlocksRead++;
+            if (swapFd != -1) {
+                SubmitSwapIo(false, bsIndex, currentPage);
+            }
+        }
+    }
+}
+
+// Function to parse one text line of the trace
+TraceRecord ParseInputLine(string_view line) {
+    TraceRecord record;
+
+    // Skip comments and empty lines
+    if (line.empty() || line[0] == '#') return record;
+
+    // Trim leading/trailing whitespace without copying the line
+    size_t firstChar = line.find_first_not_of(" \t\r\n");
+    if (firstChar == string_view::npos) {
+        line = string_view();
+    } else {
+        line = line.substr(firstChar, line.find_last_not_of(" \t\r\n") - firstChar + 1);
+    }
+    record.text = line;
+
+    // Handle commands
+    if (line == "print") {
+        record.kind = RECORD_PRINT;
+        return record;
+    }
+
+    if (line == "debug") {
+        record.kind = RECORD_DEBUG;
+        return record;
+    }
+
+    if (line == "nodebug") {
+        record.kind = RECORD_NODEBUG;
+        return record;
+    }
+
+    // Parse operation and memory location in place (tokenised like "iss >> operation >> memLocationStr")
+    static const char *const STREAM_SPACE = " \t\n\v\f\r";
+    size_t operationPos = line.find_first_not_of(STREAM_SPACE);
+    size_t tokenStart = operationPos == string_view::npos ? string_view::npos : line.find_first_not_of(STREAM_SPACE, operationPos + 1);
+    if (tokenStart == string_view::npos) {
+        record.kind = RECORD_BAD_FORMAT;
+        return record;
+    }
+    record.operation = line[operationPos];
+    record.memLocationStr = line.substr(tokenStart, line.find_first_of(STREAM_SPACE, tokenStart) - tokenStart);
+
+    // Validate operation character
+    if (record.operation != 'r' && record.operation != 'w') {
+        record.kind = RECORD_BAD_OPERATION;
+        return record;
+    }
+
+    // Parse memory location (supporting hexadecimal without '0x' prefix)
+    record.kind = ParseHexLocation(record.memLocationStr, record.memLocation);
+
+    // Under --numa a decimal CPU or node id may follow the address; otherwise extra tokens are ignored
+    size_t cpuStart = line.find_first_not_of(STREAM_SPACE, tokenStart + record.memLocationStr.size());
+    if (numaNodes && record.kind == RECORD_REFERENCE && cpuStart != string_view::npos) {
+        string_view token = line.substr(cpuStart, line.find_first_of(STREAM_SPACE, cpuStart) - cpuStart);
+        unsigned cpu = 0;
+        for (size_t i = 0; i < token.size() && cpu <= USHRT_MAX; i++) {
+            if (token[i] < '0' || token[i] > '9') {
+                cpu = USHRT_MAX + 1;
+                break;
+            }
+            cpu = cpu * 10 + (token[i] - '0');
+        }
+        if (cpu > USHRT_MAX) {
+            record.kind = RECORD_BAD_CPU;
+            return record;
+        }
+        record.cpu = cpu;
+    }
+    return record;
+}
+
+// Function to parse a hexadecimal address with the same rules as stoi(..., 16), without allocating
+RecordKind ParseHexLocation(string_view token, unsigned long long &value) {
+    size_t pos = 0;
+    bool negative = false;
+    if (pos < token.size() && (token[pos] == '+' || token[pos] == '-')) {
+        negative = token[pos] == '-';
+        pos++;
+    }
+
+    // An optional 0x prefix; "0x" with no digits after it still reads as 0
+    bool hasPrefix = false;
+    if (pos + 1 < token.size() && token[pos] == '0' && (token[pos + 1] == 'x' || token[pos + 1] == 'X')) {
+        hasPrefix = true;
+        pos += 2;
+    }
+
+    // Accumulate digits, remembering overflow but consuming the whole run like strtol
+    // (64-bit mode accepts the full range of strtoull instead of an int)
+    const unsigned long long maxMagnitude = wideAddresses ? ULLONG_MAX : (unsigned long long)INT_MAX + 1;
+    unsigned long long magnitude = 0;
+    size_t digits = 0;
+    bool overflow = false;
+    for (; pos < token.size(); pos++, digits++) {
+        char c = token[pos];
+        int digit;
+        if (c >= '0' && c <= '9') digit = c - '0';
+        else if (c >= 'a' && c <= 'f') digit = c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F') digit = c - 'A' + 10;
+        else break;
+
+        if (!overflow) {
+            if (magnitude > (maxMagnitude - digit) / 16) {
+                overflow = true;
+            } else {
+                magnitude = magnitude * 16 + digit;
+            }
+        }
+    }
+
+    if (digits == 0) {
+        if (!hasPrefix) return RECORD_BAD_LOCATION;
+        value = 0;
+        return RECORD_REFERENCE;
+    }
+
+    if (overflow) {
+        return RECORD_LOCATION_RANGE;
+    }
+
+    if (wideAddresses) {
+        value = negative ? 0 - magnitude : magnitude;
+        // Page numbers are signed, so byte-sized pages stop at 2^63
+        if (pageSize == 1 && value > (unsigned long long)LLONG_MAX) {
+            return RECORD_LOCATION_RANGE;
+        }
+        return RECORD_REFERENCE;
+    }
+
+    if (!negative && magnitude > (unsigned long long)INT_MAX) {
+        return RECORD_LOCATION_RANGE;
+    }
+
+    // Keep the sign extension the int address used to get
+    value = (unsigned long long)(negative ? -(long long)magnitude : (long long)magnitude);
+    return RECORD_REFERENCE;
+}
+
+// Function to report a line that counts as a reference but cannot be simulated
+void ReportInvalidRecord(const TraceRecord &record, size_t lineNumber) {
+    if (record.kind == RECORD_BAD_FORMAT) {
+        cerr << "Error: Invalid line format at line " << lineNumber + 1 << ": " << record.text << endl;
+    } else if (record.kind == RECORD_BAD_OPERATION) {
+        cerr << "Error: Invalid operation '" << record.operation << "' at line " << lineNumber + 1 << endl;
+    } else if (record.kind == RECORD_BAD_LOCATION) {
+        cerr << "Error: Invalid memory location at line " << lineNumber + 1 << ": " << record.memLocationStr << endl;
+    } else if (record.kind == RECORD_LOCATION_RANGE) {
+        cerr << "Error: Memory location out of range at line " << lineNumber + 1 << ": " << record.memLocationStr << endl;
+    } else if (record.kind == RECORD_BAD_CPU) {
+        cerr << "Error: Invalid CPU id at line " << lineNumber + 1 << ": " << record.text << endl;
+    }
+}
+
+void ProcessInputLine(string_view line, size_t lineNumber, Page *pageTable, Frame *frameTable) {
+    ProcessTraceRecord(ParseInputLine(line), lineNumber, pageTable, frameTable);
+}
+
+void ProcessTraceRecord(const TraceRecord &record, size_t lineNumber, Page *pageTable, Frame *frameTable) {
+    // Text traces explain an invalid line; binary traces only carry a marker
+    if (record.kind > RECORD_REFERENCE && !binaryTrace) {
+        ReportInvalidRecord(record, lineNumber);
+    }
+
+    long long currentPage = record.kind == RECORD_REFERENCE ? PageNumberFor(record.memLocation) : -1;
+    SimulateRecord(record.kind, record.operation, currentPage, record.cpu, lineNumber, pageTable, frameTable);
+}
+
+// Function to apply one parsed record to the simulation
+void SimulateRecord(RecordKind kind, char operation, long long currentPage, unsigned cpu, size_t lineNumber, Page *pageTable, Frame *frameTable) {
+    // Skip comments and empty lines
+    if (kind == RECORD_SKIP) return;
+
+    // Handle commands
+    if (kind == RECORD_PRINT) {
+        DisplayResults(pageTable, frameTable);
+        return;
+    }
+
+    if (kind == RECORD_DEBUG) {
+        debugMode = 1;
+        return;
+    }
+
+    if (kind == RECORD_NODEBUG) {
+        debugMode = 0;
+        return;
+    }
+
+    totalPageReferences++;
+
+    // Invalid lines are counted but not simulated
+    if (kind == RECORD_REFERENCE) {
+        size_t allocationsBefore = heapAllocationCount;
+        if (numaActive) {
+            accessNode = cpu % numaNodes;
+        }
+        ProcessPageReference(operation, currentPage, lineNumber, pageTable, frameTable);
+        if (intervalLength) {
+            TrackIntervalPage(currentPage);
+        }
+        referenceHeapAllocations += heapAllocationCount - allocationsBefore;
+    }
+
+    // Close the time-series window every intervalLength references
+    if (intervalLength && totalPageReferences % intervalLength == 0) {
+        EmitIntervalRow();
+    }
+}
+
+// Function to start this simulation's time series
+void InitializeIntervals() {
+    if (!intervalLength) return;
+    intervalStart = {0, 0, 0, 0, 0, 0};
+    if (!wideAddresses) {
+        pageLastInterval.assign(totalPages, -1);
+    }
+    if (intervalFd == -1 && !intervalNdjson) {
+        const char header[] = "algorithm,reference,references,misses,stolen,written,recovered,working_set\n";
+        memcpy(intervalBuffer, header, sizeof(header) - 1);
+        intervalBufferUsed = sizeof(header) - 1;
+    }
+}
+
+// Function to count a page once per window: the window's working-set size W(t, N)
+void TrackIntervalPage(long long currentPage) {
+    int &lastInterval = wideAddresses ? sparsePageLastInterval.emplace(currentPage, -1).first->second
+                                      : pageLastInterval[currentPage];
+    if (lastInterval != intervalIndex) {
+        lastInterval = intervalIndex;
+        intervalDistinctPages++;
+    }
+}
+
+// Function to append one row of per-window deltas and start the next window
+void EmitIntervalRow() {
+    const char *format = intervalNdjson
+        ? "{\"algorithm\":\"%s\",\"reference\":%d,\"references\":%d,\"misses\":%d,\"stolen\":%d,"
+          "\"written\":%d,\"recovered\":%d,\"working_set\":%d}\n"
+        : "%s,%d,%d,%d,%d,%d,%d,%d\n";
+    int length = snprintf(intervalBuffer + intervalBufferUsed, INTERVAL_BUFFER_SIZE - intervalBufferUsed, format,
+                          replacementAlgorithm, totalPageReferences,
+                          totalPageReferences - intervalStart.references,
+                          totalPageMisses - intervalStart.misses,
+                          totalFramesStolen - intervalStart.stolen,
+                          totalFramesWrittenToDisk - intervalStart.written,
+                          totalFramesRecoveredFromDisk - intervalStart.recovered,
+                          intervalDistinctPages);
+    intervalBufferUsed += length;
+    if (INTERVAL_BUFFER_SIZE - intervalBufferUsed < INTERVAL_MAX_ROW) {
+        FlushIntervalRows();
+    }
+
+    intervalStart = {totalPageReferences, totalPagesMapped, totalPageMisses,
+                     totalFramesStolen, totalFramesWrittenToDisk, totalFramesRecoveredFromDisk};
+    intervalIndex++;
+    intervalDistinctPages = 0;
+}
+
+// Function to close a partial last window and write out any buffered rows
+void FinishIntervals() {
+    if (!intervalLength) return;
+    if (totalPageReferences != intervalStart.references) {
+        EmitIntervalRow();
+    }
+    FlushIntervalRows();
+}
+
+// Function to hand the buffered rows to the interval file (one write, so rows from parallel
+// simulations never interleave mid-row) or to this simulation's report stream
+void FlushIntervalRows() {
+    if (intervalBufferUsed == 0) return;
+    if (intervalFd != -1) {
+        size_t written = 0;
+        while (written < intervalBufferUsed) {
+            ssize_t count = write(intervalFd, intervalBuffer + written, intervalBufferUsed - written);
+            if (count <= 0) {
+                cerr << "Error: Unable to write interval file " << intervalFilename << endl;
+                exit(1);
+            }
+            written += count;
+        }
+    } else if (reportOutput != nullptr) {
+        reportOutput->write(intervalBuffer, intervalBufferUsed);
+    }
+    intervalBufferUsed = 0;
+}
+
+// Function to cut the interval file back to length bytes, restarting it (with the csv header)
+// when length is 0 or unknown
+void TruncateIntervalFile(long long length) {
+    if (ftruncate(intervalFd, max(length, 0LL)) != 0) {
+        cerr << "Error: Unable to write interval file " << intervalFilename << endl;
+        exit(1);
+    }
+    if (length <= 0 && !intervalNdjson) {
+        static const char header[] = "algorithm,reference,references,misses,stolen,written,recovered,working_set\n";
+        if (write(intervalFd, header, sizeof(header) - 1) != (ssize_t)(sizeof(header) - 1)) {
+            cerr << "Error: Unable to write interval file " << intervalFilename << endl;
+            exit(1);
+        }
+    }
+}
+
+// Function to map a memory location onto its page
+long long PageNumberFor(unsigned long long memLocation) {
+    if (wideAddresses) {
+        return memLocation / pageSize;
+    }
+    return (memLocation / pageSize) % totalPages;
+}
+
+// Function to find the page table entry for a page in whichever table is in use
+inline Page &PageEntry(Page *pageTable, long long pageNumber) {
+    if (!wideAddresses) {
+        return pageTable[pageNumber];
+    }
+    return SparsePageEntry(pageNumber);
+}
+
+// Function to walk the radix page table to a page's entry, allocating missing levels
+Page &SparsePageEntry(long long pageNumber) {
+    long long leafBase = pageNumber & ~(long long)(RADIX_FANOUT - 1);
+    if (leafBase == cachedLeafBase) {
+        return cachedLeaf->entries[pageNumber & (RADIX_FANOUT - 1)];
+    }
+
+    // Grow the tree until the root covers this page number
+    if (radixHeight == 0) {
+        radixRoot = new PageLeaf;
+        radixHeight = 1;
+        radixNodesAllocated++;
+    }
+    while (radixHeight * RADIX_BITS < 63 && (pageNumber >> (radixHeight * RADIX_BITS)) != 0) {
+        RadixNode *newRoot = new RadixNode;
+        newRoot->slots[0] = radixRoot;
+        radixRoot = newRoot;
+        radixHeight++;
+        radixNodesAllocated++;
+    }
+
+    // Walk down, allocating interior nodes and leaves on first touch
+    void *node = radixRoot;
+    for (int level = radixHeight - 1; level > 0; level--) {
+        void *&slot = static_cast<RadixNode *>(node)->slots[(pageNumber >> (level * RADIX_BITS)) & (RADIX_FANOUT - 1)];
+        if (slot == nullptr) {
+            slot = level == 1 ? static_cast<void *>(new PageLeaf) : static_cast<void *>(new RadixNode);
+            radixNodesAllocated++;
+        }
+        node = slot;
+    }
+
+    cachedLeaf = static_cast<PageLeaf *>(node);
+    cachedLeafBase = leafBase;
+    return cachedLeaf->entries[pageNumber & (RADIX_FANOUT - 1)];
+}
+
+// Function to free the radix page table
+void ReleaseSparsePageTable(void *node, int level) {
+    if (node == nullptr) return;
+    if (level == 1) {
+        delete static_cast<PageLeaf *>(node);
+        return;
+    }
+    RadixNode *interior = static_cast<RadixNode *>(node);
+    for (void *child : interior->slots) {
+        ReleaseSparsePageTable(child, level - 1);
+    }
+    delete interior;
+}
+
+void ProcessPageReference(char operation, long long currentPage, size_t lineNumber, Page *pageTable, Frame *frameTable) {
+    Page &page = PageEntry(pageTable, currentPage);
+    page.status = PAGE_MAPPED;
+
+    int selectedFrame = -1;
+    bool isCacheHit = false;
+
+    // A promoted region is resident as a whole and reached through one huge page mapping
+    if (hugePagesActive && (HugeRegionSlot(currentPage >> hugePageShift) & REGION_PROMOTED)) {
+        hugePageReferences++;
+    }
+
+    // Check if page is already in a frame (the page table maps it directly)
+    if (page.frameNumber != -1) {
+        isCacheHit = true;
+        selectedFrame = page.frameNumber;
+        frameTable[selectedFrame].last_use = totalPageReferences;
+        if (frameTable[selectedFrame].isPrefetched) {
+            prefetchesUsed++;
+        }
+    }
+
+    if (!isCacheHit) {
+        totalPageMisses++;
+        selectedFrame = FindAvailableFrame(currentPage, frameTable);
+
+        // A miss on a page a prefetch fill pushed out is the prefetcher's pollution
+        if (prefetchActive) {
+            uint64_t &word = PollutionWord(currentPage);
+            uint64_t bit = 1ULL << (currentPage & 63);
+            if (word & bit) {
+                word &= ~bit;
+                prefetchPollutionMisses++;
+            }
+        }
+    }
+
+    // Update the page's last operation (first reference maps the page)
+    if (page.lastOperation == OPERATION_NONE) {
+        totalPagesMapped++;
+    }
+    page.lastOperation = operation == 'w' ? OPERATION_WRITE : OPERATION_READ;
+
+    // If no empty frame is available, apply page replacement algorithm
+    if (selectedFrame == -1) {
+        ExecutePageReplacement(currentPage, selectedFrame, pageTable, frameTable);
+    }
+
+    // Update frame and page tables
+    UpdateFrameAndPageEntries(currentPage, selectedFrame, operation, pageTable, frameTable, isCacheHit);
+
+    switch (replacementPolicy) {
+    case POLICY_FIFO:
+        // Keep the FIFO list in step with first_use: only a load moves a frame
+        if (!isCacheHit) {
+            PromoteFrameToMostRecent(selectedFrame, frameTable);
+        }
+        break;
+    case POLICY_LRU:
+    case POLICY_WS:
+        // Keep the LRU recency list in step with last_use
+        PromoteFrameToMostRecent(selectedFrame, frameTable);
+        break;
+    case POLICY_OPTIMAL:
+        // Re-key the frame by the next use of the page it now holds
+        UpdateOptimalHeap(selectedFrame, nextUseLine[lineNumber]);
+        break;
+    case POLICY_CLOCK:
+    case POLICY_ESC:
+    case POLICY_WSCLOCK:
+        // Set the reference bit the CLOCK hand clears, and give a dirty frame its second chance back
+        frameTable[selectedFrame].isReferenced = 1;
+        frameTable[selectedFrame].handPassedOver = 0;
+        break;
+    case POLICY_ARC:
+    case POLICY_2Q:
+    case POLICY_LIRS:
+        // Move the page between the ARC, 2Q or LIRS lists
+        UpdateAdaptivePolicy(currentPage, selectedFrame, isCacheHit);
+        break;
+    case POLICY_ALL:
+        break;
+    }
+
+    // Count the access as node-local or remote, migrating the page if that is enabled
+    if (numaActive) {
+        TrackNodeAccess(selectedFrame, isCacheHit, pageTable, frameTable);
+    }
+
+    // Handle loading page from disk
+    HandlePageLoadingFromDisk(currentPage, isCacheHit, pageTable);
+
+    // With -f, the last reference to a page retires it: its swap copy can never be read again
+    if (releaseRetiredPages && nextUseLine[lineNumber] == INT_MAX) {
+        page.isRetired = 1;
+        if (backingStoreEnabled && BackingStoreBlockOf(currentPage) != -1) {
+            ReleaseBackingStoreBlock(currentPage, page);
+        }
+    }
+
+    // Follow W(t, tau), and under WS release every page that has dropped out of it
+    if (IsWorkingSetAlgorithm()) {
+        TrackWorkingSet(currentPage);
+        if (replacementPolicy == POLICY_WS) {
+            TrimWorkingSet(pageTable, frameTable);
+        }
+    }
+
+    // Read ahead on demand misses
+    if (prefetchActive && !isCacheHit) {
+        IssuePrefetches(currentPage, pageTable, frameTable);
+    }
+
+    // Collapse the region into a huge page once enough of it is resident
+    if (hugePagesActive && !isCacheHit) {
+        PromoteHugeRegion(currentPage >> hugePageShift, pageTable, frameTable);
+    }
+
+    // Between references, refill the free pool once it drops under the low watermark
+    if (pageOutActive && totalFrames - framesInUse < lowWatermark) {
+        RunPageOutDaemon(pageTable, frameTable);
+    }
+}
+
+// Function to check whether the policy can give frames back early: its victim choice must not
+// depend on the page being brought in (ARC, 2Q and LIRS) or on the future (OPTIMAL)
+bool SupportsPageOutDaemon() {
+    return replacementPolicy == POLICY_FIFO || replacementPolicy == POLICY_LRU ||
+           replacementPolicy == POLICY_WS || IsClockAlgorithm();
+}
+
+// Function to run the page-out daemon, kswapd style: reclaim the policy's victims into the
+// free pool until it reaches the high watermark, then write back the dirty pages among the
+// next high-watermark victims so that their eviction will not wait for a write
+void RunPageOutDaemon(Page *pageTable, Frame *frameTable) {
+    pageOutWakeups++;
+
+    while (totalFrames - framesInUse < highWatermark) {
+        int writesBefore = totalFramesWrittenToDisk;
+        ReclaimFrame(pageTable, frameTable);
+        pageOutReclaimWrites += totalFramesWrittenToDisk - writesBefore;
+        pageOutReclaims++;
+    }
+
+    // Next victims in the policy's order: the frames ahead of the hand, or the oldest end of
+    // the list (least recently used, or loaded first under FIFO)
+    pageOutCandidates.clear();
+    if (IsClockAlgorithm()) {
+        for (size_t i = 0; i < totalFrames && pageOutCandidates.size() < highWatermark; i++) {
+            int frameIndex = (clockHand + i) % totalFrames;
+            if (frameTable[frameIndex].isInUse) {
+                pageOutCandidates.push_back(frameIndex);
+            }
+        }
+    } else {
+        for (int frameIndex = leastRecentFrame; frameIndex != -1 && pageOutCandidates.size() < highWatermark;
+             frameIndex = frameTable[frameIndex].moreRecentFrame) {
+            pageOutCandidates.push_back(frameIndex);
+        }
+    }
+    for (int frameIndex : pageOutCandidates) {
+        CleanFrame(frameIndex, pageTable, frameTable);
+    }
+}
+
+// Function to evict the policy's next victim (on victimNode, when set) into the free pool
+int ReclaimFrame(Page *pageTable, Frame *frameTable) {
+    int frameIndex = SelectFrameForReplacement(-1, pageTable, frameTable);
+    if (replacementPolicy == POLICY_FIFO || replacementPolicy == POLICY_LRU ||
+        replacementPolicy == POLICY_WS) {
+        UnlinkRecentFrame(frameIndex, frameTable);
+    }
+    StealFrame(frameIndex, pageTable, frameTable);
+    ReleaseFrame(frameIndex, frameTable);
+    return frameIndex;
+}
+
+// Function to write a resident dirty page back ahead of its eviction
+void CleanFrame(int frameIndex, Page *pageTable, Frame *frameTable) {
+    Frame &frame = frameTable[frameIndex];
+    Page &page = PageEntry(pageTable, frame.pageNumber);
+    if (page.isRetired || (page.lastOperation != OPERATION_WRITE && !frame.isDirty)) return;
+
+    WritePageToBackingStore(frame.pageNumber, page);
+    page.lastOperation = OPERATION_READ;
+    frame.isDirty = 0;
+    frame.isCleaned = 1;
+    pageOutCleanings++;
+}
+
+// Function to run the selected prefetcher after a demand miss on currentPage. At most
+// frames - 1 pages are fetched, which keeps the fills off the page that just missed under the
+// LRU list and CLOCK; ARC, 2Q and LIRS can evict a new page first, so it is pinned for them.
+void IssuePrefetches(long long currentPage, Page *pageTable, Frame *frameTable) {
+    int budget = min<long long>(prefetchDegree, (long long)totalFrames - 1);
+    pinnedPolicyNode = IsAdaptiveAlgorithm() ? PolicyDirectorySlot(currentPage) : -1;
+
+    if (prefetchPolicy == PREFETCH_NEXT) {
+        for (int i = 1; i <= budget; i++) {
+            PrefetchPage(currentPage + i, pageTable, frameTable);
+        }
+    } else if (prefetchPolicy == PREFETCH_STRIDE) {
+        // Only a stride confirmed by two consecutive miss gaps is followed
+        long long delta = strideLastMiss == -1 ? 0 : currentPage - strideLastMiss;
+        if (delta != 0 && delta == strideLastDelta) {
+            for (int i = 1; i <= budget; i++) {
+                PrefetchPage(currentPage + i * delta, pageTable, frameTable);
+            }
+        }
+        strideLastDelta = delta;
+        strideLastMiss = currentPage;
+    } else {
+        // Fetch what missed after this page last time, then record this miss as the
+        // newest successor of the previous one
+        PrefetchHistoryEntry &entry = prefetchHistory[currentPage & (PREFETCH_HISTORY_ENTRIES - 1)];
+        if (entry.pageNumber == currentPage) {
+            for (int i = 0; i < min(budget, PREFETCH_HISTORY_WAYS) && entry.successors[i] != -1; i++) {
+                PrefetchPage(entry.successors[i], pageTable, frameTable);
+            }
+        }
+
+        if (historyLastMiss != -1) {
+            PrefetchHistoryEntry &previous = prefetchHistory[historyLastMiss & (PREFETCH_HISTORY_ENTRIES - 1)];
+            if (previous.pageNumber != historyLastMiss) {
+                previous = PrefetchHistoryEntry();
+                previous.pageNumber = historyLastMiss;
+            }
+            int way = 0;
+            while (way < PREFETCH_HISTORY_WAYS - 1 && previous.successors[way] != currentPage) {
+                way++;
+            }
+            for (; way > 0; way--) {
+                previous.successors[way] = previous.successors[way - 1];
+            }
+            previous.successors[0] = currentPage;
+        }
+        historyLastMiss = currentPage;
+    }
+    pinnedPolicyNode = -1;
+}
+
+// Function to find the word holding a page's prefetch pollution bit
+inline uint64_t &PollutionWord(long long pageNumber) {
+    if (!wideAddresses) {
+        return pollutedPageBits[pageNumber >> 6];
+    }
+    SparsePageEntry(pageNumber);
+    return cachedLeaf->pollutedBits[(pageNumber & (RADIX_FANOUT - 1)) >> 6];
+}
+
+// Function to load a page the trace has not asked for yet. It is filled like a clean read
+// miss but counts as neither a reference nor a miss; the frame stays marked as prefetched
+// until the page is referenced. Returns false when the page was not fetched.
+bool PrefetchPage(long long pageNumber, Page *pageTable, Frame *frameTable) {
+    if (pageNumber < 0 || (!wideAddresses && pageNumber >= (long long)totalPages)) return false;
+    Page &page = PageEntry(pageTable, pageNumber);
+    if (page.frameNumber != -1) return false;
+
+    int selectedFrame = FindAvailableFrame(pageNumber, frameTable);
+    if (selectedFrame == -1) {
+        ExecutePageReplacement(pageNumber, selectedFrame, pageTable, frameTable);
+        if (selectedFrame == -1) return false;
+
+        // The frame still names its old page: mark it if it was a referenced page
+        if (!frameTable[selectedFrame].isPrefetched) {
+            long long victimPage = frameTable[selectedFrame].pageNumber;
+            PollutionWord(victimPage) |= 1ULL << (victimPage & 63);
+        }
+    }
+    PollutionWord(pageNumber) &= ~(1ULL << (pageNumber & 63));
+
+    if (LoadUnreferencedPage(pageNumber, selectedFrame, pageTable, frameTable)) {
+        prefetchSwapReads++;
+    }
+    frameTable[selectedFrame].isPrefetched = 1;
+    prefetchesIssued++;
+    return true;
+}
+
+// Function to bring a page nobody referenced into selectedFrame, for the prefetcher or a huge
+// page promotion. It enters the policy like a clean read miss, but with its reference bit
+// clear. Returns true when the page was read from swap.
+bool LoadUnreferencedPage(long long pageNumber, int selectedFrame, Page *pageTable, Frame *frameTable) {
+    Page &page = PageEntry(pageTable, pageNumber);
+    UpdateFrameAndPageEntries(pageNumber, selectedFrame, 'r', pageTable, frameTable, false);
+    page.status = PAGE_MAPPED;
+
+    // The copy just read matches swap, so a later eviction need not write it unless it is dirtied
+    if (page.lastOperation == OPERATION_WRITE) {
+        page.lastOperation = OPERATION_READ;
+    }
+
+    if (replacementPolicy == POLICY_FIFO || replacementPolicy == POLICY_LRU ||
+        replacementPolicy == POLICY_WS) {
+        PromoteFrameToMostRecent(selectedFrame, frameTable);
+    }
+    if (IsClockAlgorithm()) {
+        frameTable[selectedFrame].isReferenced = 0;
+        frameTable[selectedFrame].handPassedOver = 0;
+    }
+    if (IsAdaptiveAlgorithm()) {
+        UpdateAdaptivePolicy(pageNumber, selectedFrame, false);
+    }
+
+    if (!page.isOnDisk) return false;
+    int bsIndex = backingStoreEnabled ? BackingStoreBlockOf(pageNumber) : -1;
+    if (bsIndex != -1) {
+        backingStoreTable[bsIndex].readCount++;
+        backingStoreBlocksRead++;
+        if (swapFd != -1) {
+            SubmitSwapIo(false, bsIndex, pageNumber);
+        }
+    }
+    return true;
+}
+
+// Function to find the state word of a huge-page-aligned region
+int &HugeRegionSlot(long long region) {
+    if (!wideAddresses) {
+        return regionState[region];
+    }
+    return sparseRegionState.emplace(region, 0).first->second;
+}
+
+// Function to map a region as one huge page, khugepaged style, once hugePromoteThreshold
+// percent of its base pages are resident. The missing pages are filled from free frames (zero
+// pages, or swap reads for stolen ones); without enough free frames the promotion is deferred
+// to the region's next miss, as a huge page allocation would fail.
+void PromoteHugeRegion(long long region, Page *pageTable, Frame *frameTable) {
+    int &state = HugeRegionSlot(region);
+    if (state & REGION_PROMOTED) return;
+
+    // The last region of a dense page table may be cut short
+    long long firstPage = region << hugePageShift;
+    long long span = 1LL << hugePageShift;
+    if (!wideAddresses) {
+        span = min<long long>(span, totalPages - firstPage);
+    }
+    if ((long long)state * 100 < hugePromoteThreshold * span) return;
+    if ((long long)(totalFrames - framesInUse) < span - state) {
+        hugePromotionsDeferred++;
+        return;
+    }
+
+    for (long long pageNumber = firstPage; pageNumber < firstPage + span; pageNumber++) {
+        if (PageEntry(pageTable, pageNumber).frameNumber != -1) continue;
+        // A node-local pool can run dry before the global free count does
+        int selectedFrame = FindAvailableFrame(pageNumber, frameTable);
+        if (selectedFrame == -1) {
+            hugePromotionsDeferred++;
+            return;
+        }
+        if (LoadUnreferencedPage(pageNumber, selectedFrame, pageTable, frameTable)) {
+            hugeFillSwapReads++;
+        }
+        frameTable[selectedFrame].isHugeFill = 1;
+        hugeFillFrames++;
+        hugeUntouchedFrames++;
+    }
+    hugeUntouchedPeak = max(hugeUntouchedPeak, hugeUntouchedFrames);
+
+    state |= REGION_PROMOTED;
+    hugePromotions++;
+    hugePagesMapped++;
+}
+
+// Function to take an evicted page out of its region's resident count. Reclaim works on base
+// pages, so evicting a page of a promoted region first splits (demotes) its huge page.
+void ReleaseHugeRegionPage(long long pageNumber, Frame &frame) {
+    long long region = pageNumber >> hugePageShift;
+    int &state = HugeRegionSlot(region);
+    if (state & REGION_PROMOTED) {
+        state &= ~REGION_PROMOTED;
+        hugeDemotions++;
+        hugePagesMapped--;
+    }
+    state--;
+
+    if (frame.isHugeFill) {
+        frame.isHugeFill = 0;
+        hugeUntouchedFrames--;
+        hugeFillsEvictedUntouched++;
+    }
+    if (wideAddresses && state == 0) {
+        sparseRegionState.erase(region);
+    }
+}
+
+// Function to move a frame to the most recent end of the LRU list in O(1)
+void PromoteFrameToMostRecent(int frameIndex, Frame *frameTable) {
+    Frame &frame = frameTable[frameIndex];
+    if (mostRecentFrame == frameIndex) return;
+
+    // Unlink the frame if it is already on the list
+    UnlinkRecentFrame(frameIndex, frameTable);
+
+    // Append it at the most recent end
+    frame.lessRecentFrame = mostRecentFrame;
+    frame.moreRecentFrame = -1;
+    if (mostRecentFrame != -1) {
+        frameTable[mostRecentFrame].moreRecentFrame = frameIndex;
+    }
+    mostRecentFrame = frameIndex;
+    if (leastRecentFrame == -1) {
+        leastRecentFrame = frameIndex;
+    }
+}
+
+// Function to take a frame off the LRU list
+void UnlinkRecentFrame(int frameIndex, Frame *frameTable) {
+    Frame &frame = frameTable[frameIndex];
+    if (frame.lessRecentFrame != -1) {
+        frameTable[frame.lessRecentFrame].moreRecentFrame = frame.moreRecentFrame;
+    } else if (leastRecentFrame == frameIndex) {
+        leastRecentFrame = frame.moreRecentFrame;
+    }
+    if (frame.moreRecentFrame != -1) {
+        frameTable[frame.moreRecentFrame].lessRecentFrame = frame.lessRecentFrame;
+    } else if (mostRecentFrame == frameIndex) {
+        mostRecentFrame = frame.lessRecentFrame;
+    }
+    frame.lessRecentFrame = frame.moreRecentFrame = -1;
+}
+
+// Function to check whether the policy uses the rotating hand
+bool IsClockAlgorithm() {
+    return replacementPolicy == POLICY_CLOCK || replacementPolicy == POLICY_ESC ||
+           replacementPolicy == POLICY_WSCLOCK;
+}
+
+// Function to check whether the policy works from the working-set window tau
+bool IsWorkingSetAlgorithm() {
+    return replacementPolicy == POLICY_WS || replacementPolicy == POLICY_WSCLOCK;
+}
+
+// Function to advance W(t, tau) to the current reference. Every step of virtual time (invalid
+// lines included) passes through the ring once, expiring the reference made tau steps ago.
+void TrackWorkingSet(long long currentPage) {
+    while (workingSetTime < totalPageReferences) {
+        workingSetTime++;
+        long long &slot = workingSetRing[workingSetTime % workingSetWindow];
+        if (slot != -1) {
+            int lastReference = wideAddresses ? sparsePageLastReference[slot] : pageLastReference[slot];
+            if (lastReference == workingSetTime - workingSetWindow) {
+                workingSetSize--;
+            }
+        }
+        slot = -1;
+    }
+
+    int &lastReference = wideAddresses ? sparsePageLastReference.emplace(currentPage, INT_MIN / 2).first->second
+                                       : pageLastReference[currentPage];
+    if (lastReference <= totalPageReferences - workingSetWindow) {
+        workingSetSize++;
+    }
+    lastReference = totalPageReferences;
+    workingSetRing[totalPageReferences % workingSetWindow] = currentPage;
+
+    workingSetPeak = max(workingSetPeak, workingSetSize);
+    workingSetSizeSum += workingSetSize;
+    workingSetSamples++;
+}
+
+// Function to release the frames of pages not referenced in the last tau references (WS).
+// The LRU list is ordered by last_use, so only its head ever needs checking.
+void TrimWorkingSet(Page *pageTable, Frame *frameTable) {
+    while (leastRecentFrame != -1 && totalPageReferences - frameTable[leastRecentFrame].last_use >= workingSetWindow) {
+        int frameIndex = leastRecentFrame;
+        UnlinkRecentFrame(frameIndex, frameTable);
+        StealFrame(frameIndex, pageTable, frameTable);
+        ReleaseFrame(frameIndex, frameTable);
+        workingSetTrims++;
+    }
+}
+
+// Function to sweep the hand to the next victim. A referenced frame loses its bit and is
+// passed over; under ESC an unreferenced dirty frame is also passed over once, so clean
+// frames are taken before pages that must be written to swap. Under WSCLOCK a frame still
+// inside the tau window is passed over once, and an old dirty frame is cleaned (written
+// out) rather than taken, so a later pass can reclaim it without a write. Every skip or
+// cleaning is paid for by an earlier reference, so the search is amortized O(1).
+int AdvanceClockHand(Page *pageTable, Frame *frameTable) {
+    bool skipDirty = replacementPolicy == POLICY_ESC;
+    bool useWindow = replacementPolicy == POLICY_WSCLOCK;
+    while (true) {
+        Frame &frame = frameTable[clockHand];
+        int candidate = clockHand;
+        if (++clockHand == totalFrames) {
+            clockHand = 0;
+            clockHandRevolutions++;
+        }
+        clockHandAdvances++;
+
+        // Frames the page-out daemon freed are handed out by FindAvailableFrame instead, and
+        // node-local replacement passes over other nodes' frames without touching them
+        if (!frame.isInUse || (victimNode != -1 && FrameNode(candidate) != victimNode)) {
+            continue;
+        }
+        if (frame.isReferenced) {
+            frame.isReferenced = 0;
+            clockReferenceBitsCleared++;
+        } else if (skipDirty && frame.isDirty && !frame.handPassedOver) {
+            frame.handPassedOver = 1;
+            clockDirtyFramesSkipped++;
+        } else if (useWindow && totalPageReferences - frame.last_use < workingSetWindow && !frame.handPassedOver) {
+            frame.handPassedOver = 1;
+            workingSetFramesSkipped++;
+        } else if (useWindow && frame.isDirty) {
+            // The page's last write is now on disk, so stealing it later costs no write
+            Page &page = PageEntry(pageTable, frame.pageNumber);
+            WritePageToBackingStore(frame.pageNumber, page);
+            page.lastOperation = OPERATION_READ;
+            frame.isDirty = 0;
+            workingSetCleaningWrites++;
+        } else {
+            if (frame.isDirty) {
+                clockDirtyVictims++;
+            } else {
+                clockCleanVictims++;
+            }
+            return candidate;
+        }
+    }
+}
+
+// Function to check whether the policy keeps ghost lists (ARC, 2Q or LIRS)
+bool IsAdaptiveAlgorithm() {
+    return replacementPolicy == POLICY_ARC || replacementPolicy == POLICY_2Q ||
+           replacementPolicy == POLICY_LIRS;
+}
+
+// Function to find the directory slot holding a page's node index (-1 when untracked)
+int &PolicyDirectorySlot(long long pageNumber) {
+    if (!wideAddresses) {
+        return policyNodeOfPage[pageNumber];
+    }
+    return sparsePolicyNodeOfPage.emplace(pageNumber, -1).first->second;
+}
+
+// Function to start tracking a page, reusing a released node when one is available
+int CreatePolicyNode(long long pageNumber) {
+    int node;
+    if (!freePolicyNodes.empty()) {
+        node = freePolicyNodes.back();
+        freePolicyNodes.pop_back();
+        policyNodes[node] = PolicyNode();
+    } else {
+        node = policyNodes.size();
+        policyNodes.emplace_back();
+    }
+    policyNodes[node].pageNumber = pageNumber;
+    PolicyDirectorySlot(pageNumber) = node;
+    return node;
+}
 
-            // Calculate page number
-            int pageNum = (memLocation / pageSize) % totalPages;
-            pageUses[pageNum].push_back(lineIndex);
-        }
-        futurePageReferences = pageUses;
+// Function to stop tracking a page entirely
+void ReleasePolicyNode(int node) {
+    PolicyListRemove(node, 0);
+    PolicyListRemove(node, 1);
+    if (wideAddresses) {
+        sparsePolicyNodeOfPage.erase(policyNodes[node].pageNumber);
+    } else {
+        policyNodeOfPage[policyNodes[node].pageNumber] = -1;
     }
+    freePolicyNodes.push_back(node);
 }
 
-void DisplayInitialConfiguration() {
-    // Print initial configuration
-    if (!isInitialConfigPrinted && debugMode == 0) {
-        isInitialConfigPrinted = true;
+// Function to append a node at the newest end of a list, leaving its old list in that link set
+void PolicyListAppend(PolicyListId id, int node) {
+    int linkSet = id >= LIRS_QUEUE ? 1 : 0;
+    PolicyListRemove(node, linkSet);
 
-        // Output remains unchanged
-        cout << "Page size: " << pageSize << endl;
-        cout << "Num frames: " << totalFrames << endl;
-        cout << "Num pages: " << totalPages << endl;
-        cout << "Num backing blocks: " << totalBackingStoreBlocks << endl;
-        cout << "Reclaim algorithm: " << replacementAlgorithm << endl;
+    PolicyList &list = policyLists[id];
+    PolicyNode &entry = policyNodes[node];
+    entry.list[linkSet] = id;
+    entry.prev[linkSet] = list.tail;
+    entry.next[linkSet] = -1;
+    if (list.tail != -1) {
+        policyNodes[list.tail].next[linkSet] = node;
+    } else {
+        list.head = node;
     }
+    list.tail = node;
+    list.size++;
 }
 
-void ParseCommandLineArguments(int argc, char *argv[]) {
-    if (argc < 3) {  // Need at least program name + algo + filename
-        ShowUsage();
+// Function to unlink a node from whichever list it is on in one link set
+void PolicyListRemove(int node, int linkSet) {
+    PolicyNode &entry = policyNodes[node];
+    if (entry.list[linkSet] == LIST_NONE) return;
+
+    PolicyList &list = policyLists[entry.list[linkSet]];
+    if (entry.prev[linkSet] != -1) {
+        policyNodes[entry.prev[linkSet]].next[linkSet] = entry.next[linkSet];
+    } else {
+        list.head = entry.next[linkSet];
     }
+    if (entry.next[linkSet] != -1) {
+        policyNodes[entry.next[linkSet]].prev[linkSet] = entry.prev[linkSet];
+    } else {
+        list.tail = entry.prev[linkSet];
+    }
+    list.size--;
+    entry.list[linkSet] = LIST_NONE;
+    entry.prev[linkSet] = entry.next[linkSet] = -1;
+}
 
-    bool algorithmSpecified = false;
+// Function to find the oldest node of a list, passing over the pinned node; -1 if none is left
+int UnpinnedListHead(PolicyListId id) {
+    int node = policyLists[id].head;
+    if (node != -1 && node == pinnedPolicyNode) {
+        node = policyNodes[node].next[id >= LIRS_QUEUE ? 1 : 0];
+    }
+    return node;
+}
 
-    for (int i = 1; i < argc; i++) {
-        char* arg = argv[i];
+// Function to pick the victim frame for ARC, 2Q or LIRS when every frame is full. The
+// evicted page stays behind as a ghost where the policy remembers it, and the pinned page
+// is never chosen (-1 when LIRS has no other resident HIR page to give).
+int SelectAdaptiveVictim(long long currentPage) {
+    int incoming = PolicyDirectorySlot(currentPage);
+    int victim;
 
-        // Handle flags
-        if (arg[0] == '-') {
-            // Validate flag format (single character)
-            if (!arg[1] || arg[2]) {
-                ShowUsage();
-            }
+    if (replacementPolicy == POLICY_ARC) {
+        size_t t1 = policyLists[ARC_T1].size, b1 = policyLists[ARC_B1].size, b2 = policyLists[ARC_B2].size;
+        PolicyListId ghostList = incoming != -1 ? policyNodes[incoming].list[0] : LIST_NONE;
 
-            if (arg[1] == 'd') {
-                debugMode = 1;
-            }
-            else if (arg[1] == 'w') {
-                backingStoreEnabled = true;
-            }
-            else {
-                ShowUsage();
+        // A ghost hit moves p toward the list that would have kept the page
+        if (ghostList == ARC_B1) {
+            arcTargetT1 = min(totalFrames, arcTargetT1 + max<size_t>(1, b2 / b1));
+        } else if (ghostList == ARC_B2) {
+            arcTargetT1 -= min(arcTargetT1, max<size_t>(1, b1 / b2));
+        } else if (t1 + b1 == totalFrames) {
+            // L1 is full: drop its oldest ghost, or its oldest page outright when T1 fills the cache
+            if (t1 < totalFrames) {
+                ReleasePolicyNode(policyLists[ARC_B1].head);
+            } else {
+                victim = UnpinnedListHead(ARC_T1);
+                int frame = policyNodes[victim].frame;
+                ReleasePolicyNode(victim);
+                return frame;
             }
-            continue;
+        } else if (t1 + b1 + policyLists[ARC_T2].size + b2 >= 2 * totalFrames) {
+            ReleasePolicyNode(policyLists[ARC_B2].head);
         }
 
-        // Use array lookup for algorithm validation
-        static const struct { const char* name; bool* found; } VALID_ALGORITHMS[] = {
-            {"FIFO", &algorithmSpecified},
-            {"LRU", &algorithmSpecified},
-            {"OPTIMAL", &algorithmSpecified}
-        };
+        // REPLACE: evict from T1 while it exceeds its target, otherwise from T2
+        t1 = policyLists[ARC_T1].size;
+        bool fromT1 = t1 > 0 && (t1 > arcTargetT1 || (ghostList == ARC_B2 && t1 == arcTargetT1) || policyLists[ARC_T2].size == 0);
+        victim = UnpinnedListHead(fromT1 ? ARC_T1 : ARC_T2);
+        if (victim == -1) {
+            fromT1 = !fromT1;
+            victim = UnpinnedListHead(fromT1 ? ARC_T1 : ARC_T2);
+        }
+        PolicyListAppend(fromT1 ? ARC_B1 : ARC_B2, victim);
+    } else if (replacementPolicy == POLICY_2Q) {
+        // Take a remembered page off A1out first so trimming A1out cannot forget it
+        if (incoming != -1) {
+            PolicyListRemove(incoming, 0);
+        }
 
-        // Try to match algorithm first
-        if (!algorithmSpecified) {
-            bool matched = false;
-            for (const auto& valid : VALID_ALGORITHMS) {
-                if (!strcmp(arg, valid.name)) {
-                    replacementAlgorithm = arg;
-                    *valid.found = true;
-                    matched = true;
-                    break;
-                }
-            }
-            if (matched) {
-                continue;
+        // Reclaim from A1in while it is over Kin (remembering the page in A1out), else from Am
+        bool fromA1in = policyLists[TWOQ_A1IN].size > twoQueueKin || policyLists[TWOQ_AM].size == 0;
+        victim = UnpinnedListHead(fromA1in ? TWOQ_A1IN : TWOQ_AM);
+        if (victim == -1) {
+            fromA1in = !fromA1in;
+            victim = UnpinnedListHead(fromA1in ? TWOQ_A1IN : TWOQ_AM);
+        }
+        if (fromA1in) {
+            PolicyListAppend(TWOQ_A1OUT, victim);
+            if (policyLists[TWOQ_A1OUT].size > twoQueueKout) {
+                ReleasePolicyNode(policyLists[TWOQ_A1OUT].head);
             }
+        } else {
+            int frame = policyNodes[victim].frame;
+            ReleasePolicyNode(victim);
+            return frame;
         }
+    } else {
+        // Evict the oldest resident HIR page; it stays on the stack as a non-resident HIR.
+        // When that is the pinned page alone there is nothing a prefetch may take.
+        victim = UnpinnedListHead(LIRS_QUEUE);
+        if (victim == -1) return -1;
 
-        // If not algorithm and no filename yet, treat as filename
-        if (!inputFilename) {
-            inputFilename = arg;
+        // Keep the incoming page's stack entry out of reach of the non-resident trim
+        if (incoming != -1) {
+            PolicyListRemove(incoming, 1);
+        }
+        if (policyNodes[victim].list[0] == LIRS_STACK) {
+            PolicyListAppend(LIRS_NONRESIDENT, victim);
+            if (policyLists[LIRS_NONRESIDENT].size > totalFrames) {
+                ReleasePolicyNode(policyLists[LIRS_NONRESIDENT].head);
+            }
         } else {
-            ShowUsage();
+            int frame = policyNodes[victim].frame;
+            ReleasePolicyNode(victim);
+            return frame;
         }
     }
 
-    // Verify we got required parameters
-    if (!algorithmSpecified || !inputFilename) {
-        ShowUsage();
-    }
+    int frame = policyNodes[victim].frame;
+    policyNodes[victim].frame = -1;
+    return frame;
 }
 
-void LoadInputFile() {
-    ifstream inputFile(inputFilename);
-    if (!inputFile.is_open()) {
-        cerr << "Error: Cannot open file " << inputFilename << endl;
-        exit(1);
+// Function to file a referenced page into the right ARC, 2Q or LIRS list
+void UpdateAdaptivePolicy(long long currentPage, int selectedFrame, bool isCacheHit) {
+    int node = PolicyDirectorySlot(currentPage);
+    bool isGhost = !isCacheHit && node != -1;
+    if (node == -1) {
+        node = CreatePolicyNode(currentPage);
     }
+    PolicyNode &entry = policyNodes[node];
+    entry.frame = selectedFrame;
 
-    // Read the first line (skip comments)
-    string line;
-    while (getline(inputFile, line)) {
-        // Skip comments and empty lines
-        if (line.empty() || line[0] == '#') continue;
-
-        initialConfigLine = line;
+    if (replacementPolicy == POLICY_ARC) {
+        // New pages enter T1; a second reference (or a ghost hit) promotes to T2
+        PolicyListAppend(isCacheHit || isGhost ? ARC_T2 : ARC_T1, node);
+        return;
+    }
 
-        istringstream iss(line);
-        // Read pageSize, numFrame, numPage, numBackingStoreBlocks
-        if (!(iss >> pageSize >> totalFrames >> totalPages >> totalBackingStoreBlocks)) {
-            cerr << "Error: Invalid format in the first line." << endl;
-            exit(1);
+    if (replacementPolicy == POLICY_2Q) {
+        if (isCacheHit) {
+            // A1in is FIFO: re-references there do not promote
+            if (entry.list[0] == TWOQ_AM) {
+                PolicyListAppend(TWOQ_AM, node);
+            }
+        } else {
+            PolicyListAppend(isGhost ? TWOQ_AM : TWOQ_A1IN, node);
         }
-        break;
+        return;
     }
 
-    // Check if the necessary variables are set
-    if (pageSize == 0 || totalFrames == 0 || totalPages == 0) {
-        cerr << "Error: Missing or invalid page size, number of frames, or number of pages." << endl;
-        exit(1);
+    // LIRS
+    if (entry.isLir) {
+        bool wasBottom = policyLists[LIRS_STACK].head == node;
+        PolicyListAppend(LIRS_STACK, node);
+        if (wasBottom) {
+            LirsPruneStack();
+        }
+    } else if (entry.list[0] == LIRS_STACK || (!isCacheHit && lirsLirCount < lirsLirLimit)) {
+        // Short reuse distance (or warm-up): the page joins the LIR set
+        PolicyListRemove(node, 1);
+        LirsMakeLir(node);
+    } else {
+        PolicyListAppend(LIRS_STACK, node);
+        PolicyListAppend(LIRS_QUEUE, node);
     }
+}
 
-    // Read the rest of the lines
-    while (getline(inputFile, line)) {
-        inputLines.push_back(line);
-    }
+// Function to make a LIRS page LIR, demoting the bottom LIR page when the set overflows
+void LirsMakeLir(int node) {
+    policyNodes[node].isLir = true;
+    lirsLirCount++;
+    PolicyListAppend(LIRS_STACK, node);
+    LirsPruneStack();
 
-    inputFile.close();
+    if (lirsLirCount > lirsLirLimit) {
+        int bottom = policyLists[LIRS_STACK].head;
+        policyNodes[bottom].isLir = false;
+        lirsLirCount--;
+        PolicyListRemove(bottom, 0);
+        PolicyListAppend(LIRS_QUEUE, bottom);
+    }
+    LirsPruneStack();
 }
 
-void ProcessAllInputLines(Page *pageTable, Frame *frameTable) {
-    // Process each line
-    for (size_t lineIndex = 0; lineIndex < inputLines.size(); lineIndex++) {
-        ProcessInputLine(inputLines[lineIndex], lineIndex, pageTable, frameTable);
+// Function to pop HIR entries off the stack bottom so it always ends in a LIR page
+void LirsPruneStack() {
+    while (policyLists[LIRS_STACK].head != -1 && !policyNodes[policyLists[LIRS_STACK].head].isLir) {
+        int bottom = policyLists[LIRS_STACK].head;
+        if (policyNodes[bottom].frame == -1) {
+            ReleasePolicyNode(bottom);
+        } else {
+            PolicyListRemove(bottom, 0);
+        }
     }
 }
 
-void ReleaseResources(Page *pageTable, Frame *frameTable) {
-    // Clean up dynamically allocated memory
-    delete[] pageTable;
-    delete[] frameTable;
-    if (backingStoreTable != nullptr) {
-        delete[] backingStoreTable;
+// Heap order for OPTIMAL: farther next use first, lower frame index on ties
+static bool OptimalHeapBefore(int frameA, int frameB) {
+    if (frameNextUse[frameA] != frameNextUse[frameB]) {
+        return frameNextUse[frameA] > frameNextUse[frameB];
     }
+    return frameA < frameB;
 }
 
-void ExecutePageReplacement(int currentPage, int &selectedFrame, Page *pageTable, Frame *frameTable) {
-    // Select a frame to replace using the replacement algorithm
-    selectedFrame = SelectFrameForReplacement(frameTable);
-
-    // Handle the page being replaced
-    for (size_t i = 0; i < totalPages; i++) {
-        if (pageTable[i].frameNumber == selectedFrame) {
-            pageTable[i].status = "STOLEN";
-            pageTable[i].frameNumber = -1;
-
-            if (pageOperationMap.count(i) > 0) {
-                if (pageOperationMap[i] == 'w' || frameTable[selectedFrame].isDirty == 1) {
-                    pageTable[i].isOnDisk = 1;
-                    totalFramesWrittenToDisk++;
-
-                    if (backingStoreEnabled) {
-                        // If the page does not already have a backing store block
-                        if (pageTable[i].backingStoreBlock == -1) {
-                            int bsIndex = FindAvailableBackingStoreBlock();
-                            if (bsIndex == -1) {
-                                cerr << "Error: No free backing store blocks available." << endl;
-                                exit(1);
-                            }
-                            backingStoreTable[bsIndex].isInUse = 1;
-                            backingStoreTable[bsIndex].pageNumber = i;
-                            backingStoreTable[bsIndex].writeCount++;
-                            backingStoreBlocksInUse++;
-                            backingStoreBlocksWritten++;
-                            pageTable[i].backingStoreBlock = bsIndex;
-                        } else {
-                            // Page already has a backing store block, increment writes
-                            int bsIndex = pageTable[i].backingStoreBlock;
-                            backingStoreTable[bsIndex].writeCount++;
-                            backingStoreBlocksWritten++;
-                        }
-                    }
-                }
-            }
+static void OptimalHeapSwap(int posA, int posB) {
+    swap(optimalHeap[posA], optimalHeap[posB]);
+    optimalHeapPosition[optimalHeap[posA]] = posA;
+    optimalHeapPosition[optimalHeap[posB]] = posB;
+}
 
-            totalFramesStolen++;
-            break;
-        }
+// Function to insert or re-key a frame in the OPTIMAL heap in O(log frames)
+void UpdateOptimalHeap(int frameIndex, int nextUse) {
+    frameNextUse[frameIndex] = nextUse;
+
+    int pos = optimalHeapPosition[frameIndex];
+    if (pos == -1) {
+        pos = optimalHeap.size();
+        optimalHeap.push_back(frameIndex);
+        optimalHeapPosition[frameIndex] = pos;
     }
-    frameTable[selectedFrame].first_use = totalPageReferences;
-}
 
-int SelectFrameForReplacement(Frame* frameTable) {
-    if (strcmp(replacementAlgorithm, "FIFO") == 0) {
-        int oldestFrame = 0;
-        int earliestUse = frameTable[0].first_use;
-        for (size_t i = 1; i < totalFrames; i++) {
-            if (frameTable[i].first_use < earliestUse) {
-                earliestUse = frameTable[i].first_use;
-                oldestFrame = i;
-            }
-        }
-        return oldestFrame;
+    // Sift up
+    while (pos > 0) {
+        int parent = (pos - 1) / 2;
+        if (!OptimalHeapBefore(optimalHeap[pos], optimalHeap[parent])) break;
+        OptimalHeapSwap(pos, parent);
+        pos = parent;
     }
 
-    if (strcmp(replacementAlgorithm, "LRU") == 0) {
-        int lruFrame = 0;
-        int leastRecentUse = frameTable[0].last_use;
-        for (size_t i = 1; i < totalFrames; i++) {
-            if (frameTable[i].last_use < leastRecentUse) {
-                leastRecentUse = frameTable[i].last_use;
-                lruFrame = i;
-            }
-        }
-        return lruFrame;
+    // Sift down
+    int heapSize = optimalHeap.size();
+    while (true) {
+        int best = pos;
+        int left = 2 * pos + 1, right = 2 * pos + 2;
+        if (left < heapSize && OptimalHeapBefore(optimalHeap[left], optimalHeap[best])) best = left;
+        if (right < heapSize && OptimalHeapBefore(optimalHeap[right], optimalHeap[best])) best = right;
+        if (best == pos) break;
+        OptimalHeapSwap(pos, best);
+        pos = best;
     }
-    // OPTIMAL
-    int optimalFrame = 0;
-    int farthestDistance = -1;
-    for (size_t i = 0; i < totalFrames; i++) {
-        int currentPage = frameTable[i].pageNumber;
-        int distance;
+}
 
-        if (futurePageReferences[currentPage].empty()) {
-            distance = INT_MAX;
-        } else {
-            distance = futurePageReferences[currentPage][0];
+// Function to find any available (empty) frame
+int FindAvailableFrame(long long pageNumber, Frame *frameTable) {
+    // Under --numa the page goes to its placement node, or with global replacement to the
+    // next node round that still has a free frame
+    if (numaActive) {
+        numaTargetNode = numaPlacement == NUMA_INTERLEAVE ? pageNumber % numaNodes
+                       : numaPlacement == NUMA_PREFERRED ? numaPreferredNode : accessNode;
+        int frameIndex = FindNodeFrame(numaTargetNode, frameTable);
+        for (int i = 1; frameIndex == -1 && !numaNodeLocal && i < numaNodes; i++) {
+            frameIndex = FindNodeFrame((numaTargetNode + i) % numaNodes, frameTable);
         }
+        return frameIndex;
+    }
 
-        if (distance > farthestDistance) {
-            farthestDistance = distance;
-            optimalFrame = i;
-        }
+    // Frames handed back by working-set trimming are reused first
+    if (!freeFrames.empty()) {
+        int frameIndex = freeFrames.back();
+        freeFrames.pop_back();
+        return frameIndex;
     }
-    return optimalFrame;
-}
 
-// Function to update frame and page tables after a reference
-void UpdateFrameAndPageEntries(int currentPage, int selectedFrame, char operation, Page *pageTable, Frame *frameTable, bool isCacheHit) {
-    // Update the 'isDirty' flag based on cache hit and operation type
-    if (operation == 'w' || (isCacheHit && frameTable[selectedFrame].isDirty == 1)) {
-        frameTable[selectedFrame].isDirty = 1;
-    } else {
-        frameTable[selectedFrame].isDirty = 0;
+    // Frames fill in index order, so resume the scan where the last one stopped
+    while (nextUnusedFrame < totalFrames && frameTable[nextUnusedFrame].isInUse != 0) {
+        nextUnusedFrame++;
     }
+    if (nextUnusedFrame < totalFrames)
+        return nextUnusedFrame;
+    return -1;
+}
 
-    // Update the frame number for the current page
-    pageTable[currentPage].frameNumber = selectedFrame;
+// Function to find a free frame in one node's pool, the same way FindAvailableFrame does for the
+// whole frame table
+int FindNodeFrame(int node, Frame *frameTable) {
+    if (!nodeFreeFrames[node].empty()) {
+        int frameIndex = nodeFreeFrames[node].back();
+        nodeFreeFrames[node].pop_back();
+        return frameIndex;
+    }
 
-    // Mark the frame as in use
-    frameTable[selectedFrame].isInUse = 1;
+    size_t &nextFrame = nodeNextUnusedFrame[node];
+    size_t endFrame = NodeFirstFrame(node + 1);
+    while (nextFrame < endFrame && frameTable[nextFrame].isInUse != 0) {
+        nextFrame++;
+    }
+    return nextFrame < endFrame ? (int)nextFrame : -1;
+}
 
-    // Update the 'first_use' timestamp if it hasn't been set yet
-    if (frameTable[selectedFrame].first_use == -1) {
-        frameTable[selectedFrame].first_use = totalPageReferences;
+// Function to give an emptied frame back to the free pool (its node's pool under --numa)
+void ReleaseFrame(int frameIndex, Frame *frameTable) {
+    frameTable[frameIndex] = Frame();
+    if (numaActive) {
+        nodeFreeFrames[FrameNode(frameIndex)].push_back(frameIndex);
     } else {
-        frameTable[selectedFrame].first_use = frameTable[selectedFrame].first_use;
+        freeFrames.push_back(frameIndex);
     }
+    framesInUse--;
+}
 
-    // Update the 'last_use' timestamp to the current reference count
-    frameTable[selectedFrame].last_use = totalPageReferences;
+// Function to find the node a frame belongs to; node n owns frames NodeFirstFrame(n) onward
+int FrameNode(size_t frameIndex) {
+    return frameIndex * numaNodes / totalFrames;
+}
 
-    // Associate the frame with the current page
-    frameTable[selectedFrame].pageNumber = currentPage;
+size_t NodeFirstFrame(int node) {
+    return ((size_t)node * totalFrames + numaNodes - 1) / numaNodes;
 }
 
-void HandlePageLoadingFromDisk(int currentPage, bool isCacheHit, Page *pageTable) {
-    if (!isCacheHit && pageTable[currentPage].isOnDisk == 1) {
-        totalFramesRecoveredFromDisk++;
-        if (backingStoreEnabled && pageTable[currentPage].backingStoreBlock != -1) {
-            int bsIndex = pageTable[currentPage].backingStoreBlock;
-            backingStoreTable[bsIndex].readCount++;
-            backingStoreBlocksRead++;
+// Function to count a reference as local or remote to the referencing CPU's node. With
+// --numa-migrate, a page referenced twice in a row from the same remote node moves to that
+// node, as automatic NUMA balancing would. A full node first gives up its own victim when the
+// policy can pick one there (those the page-out daemon supports); otherwise the migration fails.
+void TrackNodeAccess(int selectedFrame, bool isCacheHit, Page *pageTable, Frame *frameTable) {
+    Frame &frame = frameTable[selectedFrame];
+    int pageNode = FrameNode(selectedFrame);
+    NumaNodeCounters &counters = numaCounters[accessNode];
+    counters.accesses++;
+    if (!isCacheHit) {
+        numaCounters[pageNode].pagesPlaced++;
+        if (pageNode != accessNode) {
+            counters.remoteMisses++;
         }
     }
-}
-
-void ProcessInputLine(string line, size_t lineNumber, Page *pageTable, Frame *frameTable) {
-    // Skip comments and empty lines
-    if (line.empty() || line[0] == '#') return;
 
-    // Trim leading/trailing whitespace
-    line.erase(0, line.find_first_not_of(" \t\r\n"));
-    line.erase(line.find_last_not_of(" \t\r\n") + 1);
-
-    // Handle commands
-    if (line == "print") {
-        DisplayResults(pageTable, frameTable);
+    if (pageNode == accessNode) {
+        counters.localAccesses++;
+        frame.remoteNode = 0;
         return;
     }
-
-    if (line == "debug") {
-        debugMode = 1;
+    if (!numaMigrate) return;
+    if (frame.remoteNode != (unsigned)accessNode + 1) {
+        frame.remoteNode = accessNode + 1;
         return;
     }
 
-    if (line == "nodebug") {
-        debugMode = 0;
+    int target = FindNodeFrame(accessNode, frameTable);
+    if (target == -1 && SupportsPageOutDaemon()) {
+        victimNode = accessNode;
+        ReclaimFrame(pageTable, frameTable);
+        victimNode = -1;
+        target = FindNodeFrame(accessNode, frameTable);
+        counters.migrationReclaims++;
+    }
+    if (target == -1) {
+        counters.migrationsFailed++;
         return;
     }
+    MoveFrame(selectedFrame, target, pageTable, frameTable);
+    counters.migrationsIn++;
+}
 
-    totalPageReferences++;
-
-    // Parse operation and memory location
-    istringstream iss(line);
-    char operation;
-    string memLocationStr;
+// Function to move a resident page to the free frame 'to', carrying its frame entry and its
+// place in the policy's structures along with it
+void MoveFrame(int from, int to, Page *pageTable, Frame *frameTable) {
+    Frame &source = frameTable[from];
+    frameTable[to] = source;
+    frameTable[to].remoteNode = 0;
+    PageEntry(pageTable, source.pageNumber).frameNumber = to;
 
-    if (!(iss >> operation >> memLocationStr)) {
-        cerr << "Error: Invalid line format at line " << lineNumber + 1 << ": " << line << endl;
-        return; // Skip invalid lines
+    // Relink the LRU list neighbours (frames off the list have no links)
+    if (source.lessRecentFrame != -1) {
+        frameTable[source.lessRecentFrame].moreRecentFrame = to;
+    } else if (leastRecentFrame == from) {
+        leastRecentFrame = to;
     }
-
-    // Validate operation character
-    if (operation != 'r' && operation != 'w') {
-        cerr << "Error: Invalid operation '" << operation << "' at line " << lineNumber + 1 << endl;
-        return;
+    if (source.moreRecentFrame != -1) {
+        frameTable[source.moreRecentFrame].lessRecentFrame = to;
+    } else if (mostRecentFrame == from) {
+        mostRecentFrame = to;
     }
 
-    // Parse memory location (supporting hexadecimal without '0x' prefix)
-    int memLocation;
-    try {
-        memLocation = stoi(memLocationStr, nullptr, 16); // Base 16 for hexadecimal
-    } catch (const invalid_argument &) {
-        cerr << "Error: Invalid memory location at line " << lineNumber + 1 << ": " << memLocationStr << endl;
-        return;
-    } catch (const out_of_range &) {
-        cerr << "Error: Memory location out of range at line " << lineNumber + 1 << ": " << memLocationStr << endl;
-        return;
+    if (replacementPolicy == POLICY_OPTIMAL) {
+        int position = optimalHeapPosition[from];
+        optimalHeap[position] = to;
+        optimalHeapPosition[to] = position;
+        optimalHeapPosition[from] = -1;
+        frameNextUse[to] = frameNextUse[from];
+        frameNextUse[from] = INT_MAX;
     }
-
-    // Calculate page number
-    int currentPage = (memLocation / pageSize) % totalPages;
-    pageTable[currentPage].status = "MAPPED";
-
-    int selectedFrame = -1;
-    bool isCacheHit = false;
-
-    // Update future uses for OPTIMAL algorithm
-    if (strcmp(replacementAlgorithm, "OPTIMAL") == 0) {
-        if (!futurePageReferences[currentPage].empty()) {
-            futurePageReferences[currentPage].erase(futurePageReferences[currentPage].begin());
-        }
+    if (IsAdaptiveAlgorithm()) {
+        policyNodes[PolicyDirectorySlot(source.pageNumber)].frame = to;
     }
 
-    // Check if page is already in a frame
-    for (size_t i = 0; i < totalFrames; i++) {
-        if (frameTable[i].pageNumber == currentPage) {
-            isCacheHit = true;
-            frameTable[i].last_use = totalPageReferences;
-            selectedFrame = i;
-            break;
-        }
-    }
+    // The copy took a free frame, so the frame count in use is unchanged
+    ReleaseFrame(from, frameTable);
+    framesInUse++;
+}
 
-    if (!isCacheHit) {
-        totalPageMisses++;
-        selectedFrame = FindAvailableFrame(frameTable);
+// Function to find the lowest free backing store block by descending the free bitmap
+int FindAvailableBackingStoreBlock() {
+    if (freeBlockBitmap.empty() || freeBlockBitmap.back()[0] == 0) {
+        return -1; // No free block
     }
-
-    // Update page operation map
-    if (pageOperationMap.find(currentPage) == pageOperationMap.end()) {
-        pageOperationMap[currentPage] = operation;
-        totalPagesMapped++;
-    } else {
-        pageOperationMap[currentPage] = operation;
+    size_t block = 0;
+    for (size_t level = freeBlockBitmap.size(); level-- > 0;) {
+        block = block * 64 + __builtin_ctzll(freeBlockBitmap[level][block]);
     }
+    return block;
+}
 
-    // If no empty frame is available, apply page replacement algorithm
-    if (selectedFrame == -1) {
-        ExecutePageReplacement(currentPage, selectedFrame, pageTable, frameTable);
+// Function to mark a block free or in use, updating summary bits only when a word fills or empties
+void MarkBackingStoreBlock(int block, bool isFree) {
+    size_t index = block;
+    for (vector<uint64_t> &level : freeBlockBitmap) {
+        uint64_t &word = level[index / 64];
+        bool wasEmpty = word == 0;
+        if (isFree) {
+            word |= 1ULL << (index % 64);
+        } else {
+            word &= ~(1ULL << (index % 64));
+        }
+        if (wasEmpty == (word == 0)) break;
+        index /= 64;
     }
+}
 
-    // Update frame and page tables
-    UpdateFrameAndPageEntries(currentPage, selectedFrame, operation, pageTable, frameTable, isCacheHit);
-
-    // Handle loading page from disk
-    HandlePageLoadingFromDisk(currentPage, isCacheHit, pageTable);
+// Function to hand a page's backing store block back to the free pool
+void ReleaseBackingStoreBlock(long long pageNumber, Page &page) {
+    int bsIndex = BackingStoreBlockOf(pageNumber);
+    backingStoreTable[bsIndex].isInUse = 0;
+    backingStoreTable[bsIndex].pageNumber = -1;
+    MarkBackingStoreBlock(bsIndex, true);
+    backingStoreBlocksInUse--;
+    backingStoreBlocksReleased++;
+    SetBackingStoreBlock(pageNumber, -1);
+    page.isOnDisk = 0;
 }
 
-// Function to find any available (empty) frame
-int FindAvailableFrame(Frame *frameTable) {
-    for (size_t i = 0; i < totalFrames; i++) {
-        if (frameTable[i].isInUse == 0)
-            return i;
+// Function to look up the backing store block holding a page (-1 for none)
+int BackingStoreBlockOf(long long pageNumber) {
+    if (!wideAddresses) {
+        return pageBackingStoreBlock[pageNumber];
     }
-    return -1;
+    auto it = sparsePageBackingStoreBlock.find(pageNumber);
+    return it == sparsePageBackingStoreBlock.end() ? -1 : it->second;
 }
 
-// Function to find a free backing store block
-int FindAvailableBackingStoreBlock() {
-    for (int i = 0; i < totalBackingStoreBlocks; ++i) {
-        if (backingStoreTable[i].isInUse == 0) {
-            return i;
-        }
+// Function to record (or, with -1, clear) the backing store block holding a page
+void SetBackingStoreBlock(long long pageNumber, int block) {
+    if (!wideAddresses) {
+        pageBackingStoreBlock[pageNumber] = block;
+    } else if (block == -1) {
+        sparsePageBackingStoreBlock.erase(pageNumber);
+    } else {
+        sparsePageBackingStoreBlock[pageNumber] = block;
     }
-    return -1; // No free block
 }
 
 void DisplayResults(Page *pageTable, Frame *frameTable, bool isFinalReport) {
-    if (debugMode || isFinalReport) {
-        cout << "Page Table" << endl;
-        for (size_t i = 0; i < totalPages; i++) {
-            cout << setw(5) << i;
-            if (pageTable[i].status == "UNUSED") {
-                cout << " type:" << pageTable[i].status << endl;
-            } else {
-                cout << " type:" << pageTable[i].status
-                     << " framenum:" << pageTable[i].frameNumber
-                     << " ondisk:" << pageTable[i].isOnDisk;
+    // Silent simulations (sweeps) only keep counters
+    if (reportOutput == nullptr) return;
 
-                if (backingStoreEnabled && pageTable[i].backingStoreBlock != -1) {
-                    cout << " bsblock:" << pageTable[i].backingStoreBlock;
-                }
-                cout << endl;
+    // Interval rows sharing the report stream come out in reference order
+    if (intervalFd == -1) {
+        FlushIntervalRows();
+    }
+    ostream &out = *reportOutput;
+    if (debugMode || isFinalReport) {
+        out << "Page Table" << '\n';
+        if (wideAddresses) {
+            // Only touched pages exist in the sparse table
+            DisplaySparsePageTable(radixRoot, radixHeight, 0);
+        } else {
+            for (size_t i = 0; i < totalPages; i++) {
+                DisplayPageEntry(i, pageTable[i]);
             }
         }
 
-        cout << "Frame Table" << endl;
+        out << "Frame Table" << '\n';
         for (size_t i = 0; i < totalFrames; i++) {
-            cout << setw(5) << i;
+            out << setw(5) << i;
             if (frameTable[i].isInUse == 0) {
-                cout << " inuse:" << frameTable[i].isInUse << endl;
+                out << " inuse:" << frameTable[i].isInUse << '\n';
             } else {
-                cout << " inuse:" << frameTable[i].isInUse
+                out << " inuse:" << frameTable[i].isInUse
                      << " dirty:" << frameTable[i].isDirty
                      << " first_use:" << frameTable[i].first_use
-                     << " last_use:" << frameTable[i].last_use << endl;
+                     << " last_use:" << frameTable[i].last_use
+                     << (frameTable[i].isPrefetched ? " prefetched:1" : "");
+                if (numaActive) {
+                    out << " node:" << FrameNode(i);
+                }
+                out << '\n';
             }
         }
     }
 
     if (backingStoreEnabled) {
-        cout << "Backing Store Table" << endl;
+        out << "Backing Store Table" << '\n';
         for (int i = 0; i < totalBackingStoreBlocks; i++) {
-            cout << setw(5) << i;
+            out << setw(5) << i;
             if (backingStoreTable[i].isInUse == 0) {
-                cout << " inuse:" << backingStoreTable[i].isInUse << endl;
+                out << " inuse:" << backingStoreTable[i].isInUse << '\n';
             } else {
-                cout << " inuse:" << backingStoreTable[i].isInUse
+                out << " inuse:" << backingStoreTable[i].isInUse
                      << " page:" << backingStoreTable[i].pageNumber
                      << " reads:" << backingStoreTable[i].readCount
-                     << " writes:" << backingStoreTable[i].writeCount << endl;
+                     << " writes:" << backingStoreTable[i].writeCount << '\n';
             }
         }
-        cout << "  TTL BS blocks inuse: " << backingStoreBlocksInUse << endl
-             << "  TTL BS blocks read: " << backingStoreBlocksRead << endl
-             << "  TTL BS blocks written: " << backingStoreBlocksWritten << endl;
+        out << "  TTL BS blocks inuse: " << backingStoreBlocksInUse << '\n'
+             << "  TTL BS blocks read: " << backingStoreBlocksRead << '\n'
+             << "  TTL BS blocks written: " << backingStoreBlocksWritten << '\n';
+        if (isFinalReport && swapFilename) {
+            DisplaySwapStatistics(out);
+        }
+        if (releaseRetiredPages) {
+            out << "  TTL BS blocks released: " << backingStoreBlocksReleased << '\n'
+                 << "  TTL BS blocks reused: " << backingStoreBlocksReused << '\n'
+                 << "  Peak BS blocks inuse: " << backingStoreBlocksPeak << '\n';
+        }
+    }
+
+    out << "Pages referenced: " << totalPageReferences << '\n'
+         << "Pages mapped: " << totalPagesMapped << '\n'
+         << "Page miss instances: " << totalPageMisses << '\n'
+         << "Frame stolen instances: " << totalFramesStolen << '\n'
+         << "Stolen frames written to swapspace: " << totalFramesWrittenToDisk << '\n'
+         << "Stolen frames recovered from swapspace: " << totalFramesRecoveredFromDisk << '\n';
+
+    if (releaseRetiredPages) {
+        out << "Write-backs avoided for retired pages: " << retiredPageWritesAvoided << '\n';
+    }
+
+    if (IsClockAlgorithm()) {
+        out << "Clock hand advances: " << clockHandAdvances << '\n'
+             << "Clock hand revolutions: " << clockHandRevolutions << '\n'
+             << "Reference bits cleared: " << clockReferenceBitsCleared << '\n'
+             << "Dirty frames skipped: " << clockDirtyFramesSkipped << '\n'
+             << "Clean victims: " << clockCleanVictims << '\n'
+             << "Dirty victims: " << clockDirtyVictims << '\n';
+    }
+
+    if (IsWorkingSetAlgorithm()) {
+        out << "Working-set size: " << workingSetSize << " (average "
+             << (workingSetSamples ? (double)workingSetSizeSum / workingSetSamples : 0.0)
+             << ", peak " << workingSetPeak << ")" << '\n';
+        if (replacementPolicy == POLICY_WS) {
+            out << "Working-set trims: " << workingSetTrims << '\n';
+        } else {
+            out << "Working-set frames skipped: " << workingSetFramesSkipped << '\n'
+                 << "Cleaning writes: " << workingSetCleaningWrites << '\n';
+        }
+    }
+
+    // Accuracy: used / issued. Coverage: the share of would-be misses the prefetcher absorbed.
+    if (prefetchActive) {
+        out << "Prefetcher: " << PREFETCH_NAMES[prefetchPolicy] << " (degree " << prefetchDegree << ")" << '\n'
+             << "Prefetches issued: " << prefetchesIssued << '\n'
+             << "Prefetches used: " << prefetchesUsed << '\n'
+             << "Prefetches evicted unused: " << prefetchesEvictedUnused << '\n'
+             << "Prefetch accuracy: " << (prefetchesIssued ? (double)prefetchesUsed / prefetchesIssued : 0.0) << '\n'
+             << "Prefetch coverage: "
+             << (prefetchesUsed + totalPageMisses ? (double)prefetchesUsed / (prefetchesUsed + totalPageMisses) : 0.0) << '\n'
+             << "Pollution misses: " << prefetchPollutionMisses << '\n'
+             << "Prefetch reads from swapspace: " << prefetchSwapReads << '\n';
+    }
+
+    // Write-backs the daemon took off the fault path, against the ones still left on it
+    if (pageOutActive) {
+        out << "Page-out daemon watermarks: low " << lowWatermark << " high " << highWatermark << '\n'
+             << "Page-out daemon wakeups: " << pageOutWakeups << '\n'
+             << "Frames reclaimed by daemon: " << pageOutReclaims << " (free now " << totalFrames - framesInUse << ")" << '\n'
+             << "Write-backs off the fault path: " << pageOutReclaimWrites + pageOutCleanings
+             << " (reclaim " << pageOutReclaimWrites << ", cleaning " << pageOutCleanings << ")" << '\n'
+             << "Write-backs on the fault path: " << totalFramesWrittenToDisk - pageOutReclaimWrites << '\n'
+             << "Extra writes (cleaned pages written again): " << pageOutExtraWrites << '\n';
+    }
+
+    // Promotions against what they cost: fills the trace never touched are internal fragmentation
+    if (hugePagesActive) {
+        out << "Huge page size: " << (pageSize << hugePageShift) << " (" << (1 << hugePageShift)
+             << " base pages, promoted at " << hugePromoteThreshold << "% resident)" << '\n'
+             << "Huge page promotions: " << hugePromotions << " (deferred for lack of free frames " << hugePromotionsDeferred << ")" << '\n'
+             << "Huge page demotions: " << hugeDemotions << '\n'
+             << "Huge pages mapped: " << hugePagesMapped << '\n'
+             << "References through huge pages: " << hugePageReferences << " ("
+             << (totalPageReferences ? 100.0 * hugePageReferences / totalPageReferences : 0.0) << "%)" << '\n'
+             << "Frames filled by promotion: " << hugeFillFrames << " (from swapspace " << hugeFillSwapReads << ")" << '\n'
+             << "Internal fragmentation: " << hugeUntouchedFrames << " untouched frames (peak " << hugeUntouchedPeak
+             << ", " << hugeFillsEvictedUntouched << " evicted untouched)" << '\n';
+    }
+
+    // Local against remote references, overall and per node
+    if (numaActive) {
+        NumaNodeCounters total;
+        for (const NumaNodeCounters &node : numaCounters) {
+            total.accesses += node.accesses;
+            total.localAccesses += node.localAccesses;
+            total.remoteMisses += node.remoteMisses;
+            total.migrationsIn += node.migrationsIn;
+            total.migrationReclaims += node.migrationReclaims;
+            total.migrationsFailed += node.migrationsFailed;
+        }
+        int remoteAccesses = total.accesses - total.localAccesses;
+        out << "NUMA nodes: " << numaNodes << " (placement " << NUMA_PLACEMENT_NAMES[numaPlacement];
+        if (numaPlacement == NUMA_PREFERRED) {
+            out << " " << numaPreferredNode;
+        }
+        out << ", " << (numaNodeLocal ? "node-local" : "global") << " replacement)" << '\n'
+             << "Local accesses: " << total.localAccesses << " (" << (total.accesses ? (double)total.localAccesses / total.accesses : 0.0) << ")" << '\n'
+             << "Remote accesses: " << remoteAccesses << " (" << (total.accesses ? (double)remoteAccesses / total.accesses : 0.0) << ")" << '\n'
+             << "Misses placed on a remote node: " << total.remoteMisses << '\n'
+             << "Page migrations: " << total.migrationsIn << " (evicting on the target node " << total.migrationReclaims
+             << ", failed for lack of free frames " << total.migrationsFailed << ")" << '\n';
+        for (int node = 0; node < numaNodes; node++) {
+            const NumaNodeCounters &counters = numaCounters[node];
+            out << "Node " << node << ": frames " << NodeFirstFrame(node) << "-" << NodeFirstFrame(node + 1) - 1
+                 << ", accesses " << counters.accesses << ", remote " << counters.accesses - counters.localAccesses
+                 << ", remote misses " << counters.remoteMisses << ", pages placed " << counters.pagesPlaced
+                 << ", migrated in " << counters.migrationsIn << '\n';
+        }
+    }
+
+    // Adaptive parameters and list sizes (ghost lists count pages, not frames)
+    if (replacementPolicy == POLICY_ARC) {
+        out << "ARC target T1 size (p): " << arcTargetT1 << '\n'
+             << "ARC lists: T1=" << policyLists[ARC_T1].size << " T2=" << policyLists[ARC_T2].size
+             << " B1=" << policyLists[ARC_B1].size << " B2=" << policyLists[ARC_B2].size << '\n';
+    } else if (replacementPolicy == POLICY_2Q) {
+        out << "2Q Kin: " << twoQueueKin << " Kout: " << twoQueueKout << '\n'
+             << "2Q lists: A1in=" << policyLists[TWOQ_A1IN].size << " A1out=" << policyLists[TWOQ_A1OUT].size
+             << " Am=" << policyLists[TWOQ_AM].size << '\n';
+    } else if (replacementPolicy == POLICY_LIRS) {
+        out << "LIRS LIR limit: " << lirsLirLimit << '\n'
+             << "LIRS lists: LIR=" << lirsLirCount << " HIR resident=" << policyLists[LIRS_QUEUE].size
+             << " HIR non-resident=" << policyLists[LIRS_NONRESIDENT].size
+             << " stack=" << policyLists[LIRS_STACK].size << '\n';
+    }
+
+    // Flush once per report rather than once per table row
+    out.flush();
+}
+
+void DisplayPageEntry(long long pageNumber, const Page &page) {
+    ostream &out = *reportOutput;
+    out << setw(5) << pageNumber;
+    if (page.status == PAGE_UNUSED) {
+        out << " type:" << PAGE_STATUS_NAMES[page.status] << '\n';
+    } else {
+        out << " type:" << PAGE_STATUS_NAMES[page.status]
+             << " framenum:" << page.frameNumber
+             << " ondisk:" << page.isOnDisk;
+
+        int bsIndex = backingStoreEnabled ? BackingStoreBlockOf(pageNumber) : -1;
+        if (bsIndex != -1) {
+            out << " bsblock:" << bsIndex;
+        }
+        out << '\n';
     }
+}
 
-    cout << "Pages referenced: " << totalPageReferences << endl
-         << "Pages mapped: " << totalPagesMapped << endl
-         << "Page miss instances: " << totalPageMisses << endl
-         << "Frame stolen instances: " << totalFramesStolen << endl
-         << "Stolen frames written to swapspace: " << totalFramesWrittenToDisk << endl
-         << "Stolen frames recovered from swapspace: " << totalFramesRecoveredFromDisk << endl;
+// Function to print the referenced pages of the radix table in page order
+void DisplaySparsePageTable(void *node, int level, long long basePage) {
+    if (node == nullptr) return;
+    if (level == 1) {
+        PageLeaf *leaf = static_cast<PageLeaf *>(node);
+        for (int i = 0; i < RADIX_FANOUT; i++) {
+            if (leaf->entries[i].status != PAGE_UNUSED) {
+                DisplayPageEntry(basePage + i, leaf->entries[i]);
+            }
+        }
+        return;
+    }
+    RadixNode *interior = static_cast<RadixNode *>(node);
+    for (int i = 0; i < RADIX_FANOUT; i++) {
+        DisplaySparsePageTable(interior->slots[i], level - 1, basePage + ((long long)i << ((level - 1) * RADIX_BITS)));
+    }
 }
 
 // Function to display usage information
 static void ShowUsage() {
-    printf("usage: %s [-d] [-w] {FIFO|LRU|OPTIMAL} filename\n", programName);
+    printf("usage: %s [-d] [-w] [-f] [-x] [--tau N] POLICY filename\n", programName);
+    printf("       %s [-x] --convert textfile binaryfile\n", programName);
+    printf("       %s [-x] --mrc [--sample R] [--sample-max S] filename\n", programName);
+    printf("       %s [-w] [-f] [-x] [--tau N] [--frames LIST] [--page-size LIST] POLICY filename\n", programName);
+    printf("       %s [-w] [-f] [-x] [--tau N] --bench [--pages LIST] [--frames LIST] [--refs N] [--seed N]\n", programName);
+    printf("          [--scaling] [--generator uniform,zipf,sequential,loop,phased] POLICY\n");
+    printf("       --scaling benches 64K pages on 64 frames against 10M pages on 64K frames and fails when a\n");
+    printf("          case runs more than 8 times slower per reference on the larger tables\n");
+    printf("       POLICY is FIFO, LRU, OPTIMAL, CLOCK, ESC, ARC, 2Q, LIRS, WS, WSCLOCK or ALL\n");
+    printf("       --interval N [--interval-format csv|ndjson] [--interval-file PATH] adds a row of\n");
+    printf("          per-window counters every N references to the report (or PATH)\n");
+    printf("       --checkpoint-every N [--checkpoint-file PATH] snapshots a single-policy run every N trace\n");
+    printf("          records (default PATH is filename.checkpoint); --resume PATH continues from one\n");
+    printf("       --parse-threads N parses text traces on N worker threads (default: automatic)\n");
+    printf("       R is the fraction of pages --sample keeps for an approximate curve, e.g. 0.01, and S\n");
+    printf("          caps the pages kept by lowering that fraction as the trace goes (default R 1)\n");
+    printf("       --prefetch next|stride|history [--prefetch-degree N] reads up to N pages ahead on each\n");
+    printf("          miss (default 4; not with OPTIMAL)\n");
+    printf("       --swap-file PATH [--swap-threads N] makes -w read and write its blocks in PATH with\n");
+    printf("          O_DIRECT on N I/O threads (default 4) and reports their latency\n");
+    printf("       --watermarks LOW,HIGH runs a page-out daemon that frees frames while fewer than LOW are\n");
+    printf("          free, up to HIGH, and cleans the next dirty victims (FIFO, LRU, CLOCK, ESC, WS, WSCLOCK)\n");
+    printf("       --huge-pages N [--huge-threshold PERCENT] maps each aligned run of N base pages as one\n");
+    printf("          huge page once PERCENT of it is resident (default 50; not with OPTIMAL)\n");
+    printf("       --numa N [--numa-placement first-touch|interleave|preferred] [--numa-preferred NODE]\n");
+    printf("          [--numa-replacement local|global] [--numa-migrate] splits the frames into N node pools;\n");
+    printf("          a decimal CPU id after the address picks the referencing node (id modulo N, default 0)\n");
+    printf("       -f frees the swap of pages the trace never references again\n");
+    printf("       N is the WS/WSCLOCK window in references (default 1000)\n");
+    printf("       LIST is comma-separated values or ranges, e.g. 4..4096:x2 or 512,4096\n");
     exit(1);
 }
+
+// Count every heap allocation so -d can show the reference path makes none
+void *operator new(size_t size) {
+    heapAllocationCount++;
+    if (void *memory = malloc(size ? size : 1)) {
+        return memory;
+    }
+    throw bad_alloc();
+}
+
+void operator delete(void *memory) noexcept {
+    free(memory);
+}
+
+void operator delete(void *memory, size_t) noexcept {
+    free(memory);
+}